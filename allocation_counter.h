@@ -0,0 +1,19 @@
+#pragma once
+
+#include <atomic>
+
+namespace RunButLikeActually
+{
+    // Heap allocations made so far by every thread. Only DEBUG builds count them, by replacing
+    // the global operator new in main.cpp, so it stays at 0 otherwise.
+    inline std::atomic<long long> &GetAllocationCounter()
+    {
+        static std::atomic<long long> count{0};
+        return count;
+    }
+
+    inline long long GetAllocationCount()
+    {
+        return GetAllocationCounter().load(std::memory_order_relaxed);
+    }
+} // namespace RunButLikeActually
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <array>
+#include <stdint.h>
+#include <vector>
+#include <game.h>
+
+namespace RunButLikeActually
+{
+    // Entries in the transposition table, as a power of two
+    const int AUTOPILOT_CACHE_BITS = 14;
+
+    // Plays by searching every way the next ticks could go, given the obstacles that are on the
+    // board, and only jumps when not jumping would mean crashing. The answer for each jump step
+    // and obstacle layout is kept in a transposition table, so as the same layouts come round
+    // again, over later ticks or other games, most decisions are a single lookup.
+    //
+    // The search only knows about obstacles already on the board, never ones that are still to
+    // come, so it can't peek at the random generator.
+    template <typename Config = GameConfig>
+    class BasicAutopilot
+    {
+    public:
+        typedef BasicGame<Config> GameType;
+
+        BasicAutopilot() : cache((size_t)1 << AUTOPILOT_CACHE_BITS)
+        {
+        }
+
+        void operator()(GameType &game)
+        {
+            if (game.IsJumping())
+                return;
+
+            Layout layout;
+            layout.count = game.GetObstaclesAhead(layout.distances.data(), layout.heights.data(), MAX_OBSTACLES_AHEAD);
+            while (layout.count > 0 && layout.distances[layout.count - 1] > HORIZON)
+            {
+                layout.count--;
+            }
+
+            if (!CanSurvive(0, false, false, layout))
+                game.PressJump();
+        }
+
+        long long GetCacheHits() const
+        {
+            return cacheHits;
+        }
+
+        long long GetCacheMisses() const
+        {
+            return cacheMisses;
+        }
+
+    private:
+        // Obstacles further away than this can't change what to do now, since any jump started
+        // now is over well before they arrive. Leaving them out lets far more layouts match.
+        static constexpr int HORIZON = 2 * GameType::PLAYER_JUMP_DISTANCE;
+
+        static constexpr int MAX_DISTANCE = GameType::TILE_COLS - 1 - GameType::PLAYER_POSITION;
+        static constexpr int MAX_OBSTACLES_AHEAD = MAX_DISTANCE / (GameType::HARDEST_OBSTACLE_GAP + 1) + 1;
+
+        // Obstacles ahead of the player, closest first
+        struct Layout
+        {
+            int count = 0;
+            std::array<int, MAX_OBSTACLES_AHEAD> distances = {};
+            std::array<int, MAX_OBSTACLES_AHEAD> heights = {};
+        };
+
+        struct CacheEntry
+        {
+            uint64_t key = 0;
+            bool isUsed = false;
+            bool canSurvive = false;
+        };
+
+        static constexpr int BitsFor(int value)
+        {
+            return value > 0 ? 1 + BitsFor(value >> 1) : 0;
+        }
+
+        // Keys pack the whole state, so the table never mixes two states up
+        static constexpr int COUNT_BITS = BitsFor(MAX_OBSTACLES_AHEAD);
+        static constexpr int STEP_BITS = BitsFor(GameType::PLAYER_JUMP_DISTANCE - 2);
+        static constexpr int DISTANCE_BITS = BitsFor(MAX_DISTANCE);
+        static constexpr int HEIGHT_BITS = BitsFor(GameType::MAX_OBSTACLE_HEIGHT);
+        static_assert(COUNT_BITS + STEP_BITS + 1 + MAX_OBSTACLES_AHEAD * (DISTANCE_BITS + HEIGHT_BITS) <= 64, "The search state has to fit in a 64 bit key");
+
+        std::vector<CacheEntry> cache;
+        long long cacheHits = 0;
+        long long cacheMisses = 0;
+
+        static uint64_t GetKey(int step, bool isJumping, const Layout &layout)
+        {
+            uint64_t key = (uint64_t)layout.count;
+            key = (key << STEP_BITS) | (uint64_t)step;
+            key = (key << 1) | isJumping;
+            for (int i = 0; i < layout.count; i++)
+            {
+                key = (key << DISTANCE_BITS) | (uint64_t)layout.distances[i];
+                key = (key << HEIGHT_BITS) | (uint64_t)layout.heights[i];
+            }
+            return key;
+        }
+
+        CacheEntry &GetCacheEntry(uint64_t key)
+        {
+            return cache[(key * 0x9e3779b97f4a7c15ull) >> (64 - AUTOPILOT_CACHE_BITS)];
+        }
+
+        // Whether some choice of jumps gets the player past every obstacle in the layout, when
+        // they're on the given step and may press jump before the next tick
+        bool CanSurvive(int step, bool isJumping, bool isJumpPressed, const Layout &layout)
+        {
+            if (layout.count == 0)
+                return true;
+
+            // Same as UpdatePlayerPosition()
+            isJumping = isJumping || isJumpPressed;
+            if (isJumping)
+            {
+                step++;
+                if (step == GameType::PLAYER_JUMP_DISTANCE - 1)
+                {
+                    step = 0;
+                    isJumping = false;
+                }
+            }
+
+            // Then everything scrolls one column closer and the closest obstacle may reach us
+            Layout next;
+            for (int i = 0; i < layout.count; i++)
+            {
+                int distance = layout.distances[i] - 1;
+                if (distance == 0 && layout.heights[i] > GameType::GetJumpHeight(step))
+                    return false;
+
+                if (distance > 0)
+                {
+                    next.distances[next.count] = distance;
+                    next.heights[next.count] = layout.heights[i];
+                    next.count++;
+                }
+            }
+
+            return CanSurviveFrom(step, isJumping, next);
+        }
+
+        bool CanSurviveFrom(int step, bool isJumping, const Layout &layout)
+        {
+            if (layout.count == 0)
+                return true;
+
+            uint64_t key = GetKey(step, isJumping, layout);
+            CacheEntry &entry = GetCacheEntry(key);
+            if (entry.isUsed && entry.key == key)
+            {
+                cacheHits++;
+                return entry.canSurvive;
+            }
+            cacheMisses++;
+
+            // Waiting is tried first so jumps are left as late as they can be
+            bool canSurvive = CanSurvive(step, isJumping, false, layout) ||
+                              (!isJumping && CanSurvive(step, isJumping, true, layout));
+
+            entry.key = key;
+            entry.isUsed = true;
+            entry.canSurvive = canSurvive;
+            return canSurvive;
+        }
+    };
+
+    typedef BasicAutopilot<> Autopilot;
+} // namespace RunButLikeActually
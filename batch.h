@@ -0,0 +1,261 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <autopilot.h>
+#include <game.h>
+#include <headless.h>
+#include <multi_game.h>
+
+namespace RunButLikeActually
+{
+    const long long BATCH_DEFAULT_MAX_TICKS = 100000;
+    const int BATCH_MULTI_GAME_SIZE = 1024;
+
+    // Stands in for a jump distance to have the Autopilot play instead of ScriptedPolicy
+    const int BATCH_AUTOPILOT = 0;
+
+    struct BatchOptions
+    {
+        long long games = 1000;
+        uint64_t seed = 0;
+
+        // Games that survive this long are stopped so the batch always finishes
+        long long maxTicks = BATCH_DEFAULT_MAX_TICKS;
+
+        // Every game plays with one of these jump distances, spread evenly over the batch
+        vector<int> jumpDistances = {SCRIPTED_JUMP_DISTANCE};
+
+        // 0 uses one thread per core
+        int threads = 0;
+
+        // Plays games in groups on the MultiGame engine instead of one Game at a time. It only
+        // has the fixed generator, so it can't be used with a difficulty curve or a level.
+        bool useMultiGame = false;
+
+        // Passed on to every game, like they are in GameOptions. The level has to outlive the batch.
+        DifficultyCurve difficulty;
+        const Level *level = nullptr;
+
+        bool UsesFixedGenerator() const
+        {
+            return difficulty.pointsPerStep <= 0 && !level;
+        }
+    };
+
+    struct BatchGameResult
+    {
+        int jumpDistance;
+        int score;
+        long long ticks;
+    };
+
+    struct BatchDistribution
+    {
+        double mean = 0;
+        double p10 = 0;
+        double p50 = 0;
+        double p90 = 0;
+        double max = 0;
+
+        static BatchDistribution From(vector<double> values)
+        {
+            BatchDistribution distribution;
+            if (values.empty())
+                return distribution;
+
+            std::sort(values.begin(), values.end());
+
+            double total = 0;
+            for (double value : values)
+            {
+                total += value;
+            }
+
+            distribution.mean = total / values.size();
+            distribution.p10 = values[(values.size() - 1) / 10];
+            distribution.p50 = values[(values.size() - 1) / 2];
+            distribution.p90 = values[(values.size() - 1) * 9 / 10];
+            distribution.max = values.back();
+            return distribution;
+        }
+    };
+
+    struct BatchPolicyStats
+    {
+        int jumpDistance = 0;
+        long long games = 0;
+        long long survivedGames = 0;
+        BatchDistribution scores;
+        BatchDistribution ticks;
+    };
+
+    struct BatchResult
+    {
+        vector<BatchGameResult> games;
+        double seconds = 0;
+        long long totalTicks = 0;
+
+        // Collects the distributions for each jump distance in the order they were given
+        vector<BatchPolicyStats> GetPolicyStats(const BatchOptions &options) const
+        {
+            vector<BatchPolicyStats> stats;
+
+            for (int jumpDistance : options.jumpDistances)
+            {
+                BatchPolicyStats policyStats;
+                policyStats.jumpDistance = jumpDistance;
+
+                vector<double> scores;
+                vector<double> ticks;
+                for (const BatchGameResult &game : games)
+                {
+                    if (game.jumpDistance != jumpDistance)
+                        continue;
+
+                    scores.push_back(game.score);
+                    ticks.push_back((double)game.ticks);
+                    policyStats.survivedGames += game.ticks >= options.maxTicks;
+                }
+
+                policyStats.games = (long long)scores.size();
+                policyStats.scores = BatchDistribution::From(scores);
+                policyStats.ticks = BatchDistribution::From(ticks);
+                stats.push_back(policyStats);
+            }
+
+            return stats;
+        }
+    };
+
+    // Plays game i of a batch on its own
+    inline BatchGameResult PlayBatchGame(const BatchOptions &options, long long i, int jumpDistance, Autopilot &autopilot)
+    {
+        GameOptions gameOptions;
+        gameOptions.seed = options.seed + (uint64_t)i;
+        gameOptions.difficulty = options.difficulty;
+        gameOptions.level = options.level;
+        Game game(gameOptions);
+
+        ScriptedPolicy policy;
+        policy.jumpDistance = jumpDistance;
+
+        do
+        {
+            if (jumpDistance == BATCH_AUTOPILOT)
+                autopilot(game);
+            else
+                policy(game);
+        } while (game.Step() && game.GetTickCount() < options.maxTicks);
+
+        return {jumpDistance, game.GetScore(), game.GetTickCount()};
+    }
+
+    // Plays independent games on every core. Game i uses seed + i, so a batch is reproducible
+    // whatever the thread count is.
+    inline BatchResult RunBatch(const BatchOptions &options)
+    {
+        if (options.useMultiGame && !options.UsesFixedGenerator())
+            throw "MultiGame can't play a difficulty curve or a level.";
+
+        BatchResult result;
+        result.games.resize((size_t)options.games);
+
+        int threadCount = options.threads > 0 ? options.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+        std::atomic<long long> nextGame{0};
+        std::atomic<long long> totalTicks{0};
+
+        // Each thread keeps its own autopilot, so its cache carries over between games
+        auto worker = [&]() {
+            long long ticks = 0;
+            Autopilot autopilot;
+
+            for (long long i = nextGame++; i < options.games; i = nextGame++)
+            {
+                int jumpDistance = options.jumpDistances[(size_t)i % options.jumpDistances.size()];
+                result.games[(size_t)i] = PlayBatchGame(options, i, jumpDistance, autopilot);
+                ticks += result.games[(size_t)i].ticks;
+            }
+
+            totalTicks += ticks;
+        };
+
+        // Games that share a jump distance are grouped up for the MultiGame engine. Distances
+        // it can't play fall back to one group per game.
+        vector<vector<long long>> groups;
+        if (options.useMultiGame)
+        {
+            for (size_t policy = 0; policy < options.jumpDistances.size(); policy++)
+            {
+                bool isSupported = MultiGame::IsSupportedJumpDistance(options.jumpDistances[policy]);
+                for (long long i = (long long)policy; i < options.games; i += (long long)options.jumpDistances.size())
+                {
+                    if (groups.empty() || !isSupported || groups.back().size() >= (size_t)BATCH_MULTI_GAME_SIZE ||
+                        result.games[(size_t)groups.back().front()].jumpDistance != options.jumpDistances[policy])
+                    {
+                        groups.emplace_back();
+                    }
+                    groups.back().push_back(i);
+                    result.games[(size_t)i].jumpDistance = options.jumpDistances[policy];
+                }
+            }
+        }
+
+        std::atomic<size_t> nextGroup{0};
+        auto multiGameWorker = [&]() {
+            long long ticks = 0;
+            Autopilot autopilot;
+
+            for (size_t group = nextGroup++; group < groups.size(); group = nextGroup++)
+            {
+                const vector<long long> &indices = groups[group];
+                int jumpDistance = result.games[(size_t)indices.front()].jumpDistance;
+
+                if (!MultiGame::IsSupportedJumpDistance(jumpDistance))
+                {
+                    result.games[(size_t)indices.front()] = PlayBatchGame(options, indices.front(), jumpDistance, autopilot);
+                    ticks += result.games[(size_t)indices.front()].ticks;
+                    continue;
+                }
+
+                vector<uint64_t> seeds;
+                for (long long i : indices)
+                {
+                    seeds.push_back(options.seed + (uint64_t)i);
+                }
+
+                MultiGame multiGame(seeds, jumpDistance, options.maxTicks);
+                multiGame.Run();
+
+                for (size_t j = 0; j < indices.size(); j++)
+                {
+                    result.games[(size_t)indices[j]] = {jumpDistance, multiGame.GetScore((int)j), multiGame.GetTicks((int)j)};
+                    ticks += multiGame.GetTicks((int)j);
+                }
+            }
+
+            totalTicks += ticks;
+        };
+
+        auto start = std::chrono::steady_clock::now();
+
+        vector<std::thread> threads;
+        for (int i = 0; i < threadCount; i++)
+        {
+            if (options.useMultiGame)
+                threads.emplace_back(multiGameWorker);
+            else
+                threads.emplace_back(worker);
+        }
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.totalTicks = totalTicks;
+        return result;
+    }
+} // namespace RunButLikeActually
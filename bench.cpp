@@ -0,0 +1,244 @@
+#include <game.h>
+#include <headless.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+namespace RunButLikeActually
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int BENCH_WARMUP_TICKS = 1000;
+    const int BENCH_SAMPLES = 20000;
+    const int BENCH_INPUT_SAMPLES = 2000;
+
+    // Boards either side of the default one, to see how each stage scales with the grid
+    struct SmallBenchConfig : GameConfig
+    {
+        static constexpr int TILE_ROWS = 16;
+        static constexpr int TILE_COLS = 40;
+        static constexpr int PLAYER_POSITION = 10;
+    };
+
+    struct LargeBenchConfig : GameConfig
+    {
+        static constexpr int TILE_COLS = 240;
+        static constexpr int PLAYER_POSITION = 60;
+        static constexpr int MAX_OBSTACLE_GAP = 240;
+    };
+
+    // Exposes the stages of a tick so they can be timed one at a time
+    template <typename Config>
+    class BenchGame : public BasicGame<Config>
+    {
+    public:
+        BenchGame(GameOptions options) : BasicGame<Config>(options)
+        {
+        }
+
+        using BasicGame<Config>::BuildFrame;
+        using BasicGame<Config>::PrintGameState;
+        using BasicGame<Config>::ProcessInputEvents;
+        using BasicGame<Config>::UpdateObstacles;
+        using BasicGame<Config>::UpdatePlayerPosition;
+        using BasicGame<Config>::UpdateScore;
+        using BasicGame<Config>::UpdateTilesAndCheckForCollisions;
+    };
+
+    // Points stdout at the null device for as long as it lives, so drawing costs what it would on
+    // an infinitely fast terminal.
+    class NullOutput
+    {
+    public:
+        NullOutput()
+        {
+            fflush(stdout);
+#ifdef _WIN32
+            savedHandle = GetStdHandle(STD_OUTPUT_HANDLE);
+            nullHandle = CreateFileA("NUL", GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+            SetStdHandle(STD_OUTPUT_HANDLE, nullHandle);
+#else
+            savedFd = dup(STDOUT_FILENO);
+            int nullFd = open("/dev/null", O_WRONLY);
+            dup2(nullFd, STDOUT_FILENO);
+            close(nullFd);
+#endif
+        }
+
+        ~NullOutput()
+        {
+#ifdef _WIN32
+            SetStdHandle(STD_OUTPUT_HANDLE, savedHandle);
+            CloseHandle(nullHandle);
+#else
+            dup2(savedFd, STDOUT_FILENO);
+            close(savedFd);
+#endif
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE savedHandle;
+        HANDLE nullHandle;
+#else
+        int savedFd;
+#endif
+    };
+
+    class StageTimings
+    {
+    public:
+        explicit StageTimings(const char *name) : name(name)
+        {
+            samples.reserve(BENCH_SAMPLES);
+        }
+
+        void Add(Clock::duration duration)
+        {
+            samples.push_back(std::chrono::duration<double, std::nano>(duration).count());
+        }
+
+        void Print(double overhead)
+        {
+            std::sort(samples.begin(), samples.end());
+
+            double total = 0;
+            for (double sample : samples)
+            {
+                total += sample;
+            }
+
+            printf("%-36s %10.0f %10.0f %10.0f\n", name,
+                   std::max(0.0, Percentile(0.5) - overhead),
+                   std::max(0.0, Percentile(0.99) - overhead),
+                   std::max(0.0, total / samples.size() - overhead));
+        }
+
+    private:
+        const char *name;
+        vector<double> samples;
+
+        double Percentile(double fraction)
+        {
+            return samples[(size_t)(fraction * (samples.size() - 1))];
+        }
+    };
+
+    // How long it takes to read the clock twice, which is taken off every sample
+    double MeasureTimerOverhead()
+    {
+        vector<double> samples;
+
+        for (int i = 0; i < BENCH_SAMPLES; i++)
+        {
+            Clock::time_point start = Clock::now();
+            Clock::time_point end = Clock::now();
+            samples.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    template <typename Config>
+    void BenchTick(double overhead)
+    {
+        printf("grid: %dx%d\n", BasicGame<Config>::TILE_ROWS, BasicGame<Config>::TILE_COLS);
+
+        GameOptions options;
+        options.seed = 1;
+        BenchGame<Config> game(options);
+        ScriptedPolicy policy;
+
+        for (int i = 0; i < BENCH_WARMUP_TICKS; i++)
+        {
+            policy(game);
+            game.Step();
+        }
+
+        StageTimings tiles("UpdateTilesAndCheckForCollisions");
+        StageTimings obstacles("UpdateObstacles");
+        StageTimings frame("BuildFrame");
+        StageTimings print("PrintGameState (/dev/null)");
+
+        {
+            NullOutput nullOutput;
+
+            for (int i = 0; i < BENCH_SAMPLES; i++)
+            {
+                policy(game);
+                game.ProcessInputEvents();
+                game.UpdateScore();
+                game.UpdatePlayerPosition();
+
+                Clock::time_point start = Clock::now();
+                game.UpdateTilesAndCheckForCollisions();
+                Clock::time_point end = Clock::now();
+                tiles.Add(end - start);
+
+                start = Clock::now();
+                game.UpdateObstacles();
+                end = Clock::now();
+                obstacles.Add(end - start);
+
+                start = Clock::now();
+                game.BuildFrame();
+                end = Clock::now();
+                frame.Add(end - start);
+
+                start = Clock::now();
+                game.PrintGameState();
+                end = Clock::now();
+                print.Add(end - start);
+            }
+        }
+
+        tiles.Print(overhead);
+        obstacles.Print(overhead);
+        frame.Print(overhead);
+        print.Print(overhead);
+    }
+
+    void BenchInputPoll(double overhead)
+    {
+        StageTimings legacy("input poll (kbhit)");
+        StageTimings console("input poll (ConsoleInput)");
+
+        for (int i = 0; i < BENCH_INPUT_SAMPLES; i++)
+        {
+            Clock::time_point start = Clock::now();
+            kbhit();
+            Clock::time_point end = Clock::now();
+            legacy.Add(end - start);
+        }
+
+        ConsoleInput input;
+        for (int i = 0; i < BENCH_INPUT_SAMPLES; i++)
+        {
+            Clock::time_point start = Clock::now();
+            input.Poll();
+            Clock::time_point end = Clock::now();
+            console.Add(end - start);
+        }
+
+        legacy.Print(overhead);
+        console.Print(overhead);
+    }
+} // namespace RunButLikeActually
+
+int main()
+{
+    using namespace RunButLikeActually;
+
+    double overhead = MeasureTimerOverhead();
+
+    printf("samples: %d, timer overhead: %.0f ns\n", BENCH_SAMPLES, overhead);
+    printf("%-36s %10s %10s %10s\n", "stage (ns per call)", "p50", "p99", "mean");
+    BenchTick<SmallBenchConfig>(overhead);
+    BenchTick<GameConfig>(overhead);
+    BenchTick<LargeBenchConfig>(overhead);
+    printf("input\n");
+    BenchInputPoll(overhead);
+    return 0;
+}
@@ -1 +1,2 @@
-g++ main.cpp -o main -I . -Wall -Wextra
\ No newline at end of file
+g++ main.cpp -o main -std=c++20 -I . -Wall -Wextra -lws2_32
+g++ bench.cpp -o bench -std=c++20 -I . -O2 -Wall -Wextra
\ No newline at end of file
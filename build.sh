@@ -1 +1,3 @@
-g++ main.cpp -o main -I . -Wall -Wextra
\ No newline at end of file
+g++ main.cpp -o main -std=c++20 -I . -Wall -Wextra
+g++ bench.cpp -o bench -std=c++20 -I . -O2 -Wall -Wextra
+g++ latency.cpp -o latency -std=c++20 -I . -O2 -Wall -Wextra -lutil
\ No newline at end of file
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace RunButLikeActually
+{
+    // A coroutine run by a TaskScheduler. It starts suspended, and is destroyed along with the
+    // Task wherever it's got up to.
+    class Task
+    {
+    public:
+        struct promise_type
+        {
+            Task get_return_object()
+            {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept
+            {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void return_void()
+            {
+            }
+
+            void unhandled_exception()
+            {
+                std::terminate();
+            }
+        };
+
+        Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr))
+        {
+        }
+
+        ~Task()
+        {
+            if (handle)
+                handle.destroy();
+        }
+
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+
+        bool IsDone() const
+        {
+            return !handle || handle.done();
+        }
+
+        std::coroutine_handle<> GetHandle() const
+        {
+            return handle;
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle;
+
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle)
+        {
+        }
+    };
+
+    // Runs Tasks on the calling thread, resuming each one once what it's waiting for happens:
+    // a point in time, stdin having something to read, or a TaskEvent being set. In between it
+    // blocks until the earliest of those, so nothing wakes up late or spins.
+    class TaskScheduler
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        TaskScheduler() = default;
+
+        TaskScheduler(const TaskScheduler &) = delete;
+        TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+        // Has the task start once Run() gets to it. The task has to outlive Run().
+        void Spawn(Task &task)
+        {
+            Wake(task.GetHandle());
+        }
+
+        // Runs until task has finished and nothing else is ready to. Whatever's still waiting
+        // is left where it is, to be destroyed with its Task.
+        void Run(Task &task)
+        {
+            Spawn(task);
+
+            while (true)
+            {
+                // Anything these wake goes in ready for the next pass, and swapping the two
+                // lists keeps both their allocations
+                std::swap(ready, resuming);
+                for (std::coroutine_handle<> handle : resuming)
+                {
+                    handle.resume();
+                }
+                resuming.clear();
+
+                // Checking for input between every pass means a task that keeps waking itself
+                // can't keep the rest from running
+                if ((task.IsDone() && ready.empty()) || !WaitForWakeUp())
+                    break;
+            }
+
+            sleepers.clear();
+            inputWaiters.clear();
+        }
+
+        void Wake(std::coroutine_handle<> handle)
+        {
+            ready.push_back(handle);
+        }
+
+        struct SleepAwaiter
+        {
+            TaskScheduler &scheduler;
+            Clock::time_point time;
+
+            // Even a time that's already passed goes to the back of the queue, so a task that's
+            // behind still lets the others run
+            bool await_ready() const
+            {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                if (Clock::now() >= time)
+                    scheduler.Wake(handle);
+                else
+                    scheduler.sleepers.push_back({time, handle});
+            }
+
+            void await_resume() const
+            {
+            }
+        };
+
+        struct InputAwaiter
+        {
+            TaskScheduler &scheduler;
+
+            bool await_ready() const
+            {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                scheduler.inputWaiters.push_back(handle);
+            }
+
+            void await_resume() const
+            {
+            }
+        };
+
+        SleepAwaiter SleepUntil(Clock::time_point time)
+        {
+            return {*this, time};
+        }
+
+        // Resumes once stdin has something to read, or has been closed
+        InputAwaiter WaitForInput()
+        {
+            return {*this};
+        }
+
+    private:
+        struct Sleeper
+        {
+            Clock::time_point time;
+            std::coroutine_handle<> handle;
+        };
+
+        std::vector<std::coroutine_handle<>> ready;
+        std::vector<std::coroutine_handle<>> resuming;
+        std::vector<Sleeper> sleepers;
+        std::vector<std::coroutine_handle<>> inputWaiters;
+
+        // Blocks until the first sleeper is due or stdin can be read, and queues whoever that
+        // wakes. Doesn't block if anything is ready already. Returns false if there's nothing to
+        // wait for.
+        bool WaitForWakeUp()
+        {
+            if (ready.empty() && sleepers.empty() && inputWaiters.empty())
+                return false;
+
+            // Only a few tasks ever sleep at once, so they aren't worth keeping in order
+            Clock::time_point deadline = ready.empty() ? Clock::time_point::max() : Clock::now();
+            for (const Sleeper &sleeper : sleepers)
+            {
+                deadline = std::min(deadline, sleeper.time);
+            }
+
+            if (inputWaiters.empty())
+            {
+                std::this_thread::sleep_until(deadline);
+            }
+            else if (WaitForStdin(deadline, !sleepers.empty() || !ready.empty()))
+            {
+                ready.insert(ready.end(), inputWaiters.begin(), inputWaiters.end());
+                inputWaiters.clear();
+            }
+
+            Clock::time_point now = Clock::now();
+            for (size_t i = 0; i < sleepers.size();)
+            {
+                if (sleepers[i].time > now)
+                {
+                    i++;
+                    continue;
+                }
+
+                ready.push_back(sleepers[i].handle);
+                sleepers[i] = sleepers.back();
+                sleepers.pop_back();
+            }
+            return true;
+        }
+
+        // Returns true if stdin can be read before the deadline, which is ignored without hasDeadline
+        static bool WaitForStdin(Clock::time_point deadline, bool hasDeadline)
+        {
+#ifdef _WIN32
+            DWORD timeout = INFINITE;
+            if (hasDeadline)
+            {
+                long long timeoutMs = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now()).count();
+                timeout = (DWORD)std::max(0LL, timeoutMs);
+            }
+            return WaitForSingleObject(GetStdHandle(STD_INPUT_HANDLE), timeout) == WAIT_OBJECT_0;
+#else
+            struct pollfd fd = {};
+            fd.fd = STDIN_FILENO;
+            fd.events = POLLIN;
+
+            while (true)
+            {
+                long long timeoutNs = std::max<long long>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - Clock::now()).count());
+#ifdef __linux__
+                // ppoll() takes the timeout to the nanosecond, poll() only to the millisecond
+                struct timespec timeout = {(time_t)(timeoutNs / 1000000000), (long)(timeoutNs % 1000000000)};
+                int result = ppoll(&fd, 1, hasDeadline ? &timeout : NULL, NULL);
+#else
+                int result = poll(&fd, 1, hasDeadline ? (int)((timeoutNs + 999999) / 1000000) : -1);
+#endif
+                if (result < 0 && errno == EINTR)
+                    continue;
+
+                // Errors wake whoever's waiting too, so they can find out stdin has gone
+                return result > 0 && (fd.revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)) != 0;
+            }
+#endif
+        }
+    };
+
+    // Something a Task can wait for with co_await until another one calls Set(). A Set() with
+    // nobody waiting is kept for the next co_await, and only one Task can wait at a time.
+    class TaskEvent
+    {
+    public:
+        explicit TaskEvent(TaskScheduler &scheduler) : scheduler(scheduler)
+        {
+        }
+
+        TaskEvent(const TaskEvent &) = delete;
+        TaskEvent &operator=(const TaskEvent &) = delete;
+
+        void Set()
+        {
+            if (waiter)
+                scheduler.Wake(std::exchange(waiter, nullptr));
+            else
+                isSet = true;
+        }
+
+        bool await_ready()
+        {
+            return std::exchange(isSet, false);
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            waiter = handle;
+        }
+
+        void await_resume() const
+        {
+        }
+
+    private:
+        TaskScheduler &scheduler;
+        std::coroutine_handle<> waiter;
+        bool isSet = false;
+    };
+} // namespace RunButLikeActually
@@ -0,0 +1,1052 @@
+#pragma once
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#ifndef DEBUG
+#define DEBUG 0
+#endif
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+#include <array>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <spectator.h>
+#include <rlutil.h>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <coroutine.h>
+#include <allocation_counter.h>
+#include <input.h>
+#include <level.h>
+#include <profiler.h>
+#include <random.h>
+#include <replay.h>
+#include <score_log.h>
+#include <spsc_queue.h>
+#include <renderer.h>
+#include <terminal.h>
+#include <timestep.h>
+#include <triple_buffer.h>
+
+namespace RunButLikeActually
+{
+    using std::array;
+    using std::atomic;
+    using std::cout;
+    using std::string;
+    using std::thread;
+    using std::vector;
+
+    // Game
+    const int GAME_SPEED = 10;
+    const int GAME_MAX_CATCH_UP_TICKS = 5;
+    const size_t GAME_INPUT_QUEUE_SIZE = 64;
+    const int GAME_LEGACY_INPUT_POLL_MS = 1;
+#if DEBUG
+    const int GAME_DEBUG_ROWS = 13;
+#else
+    const int GAME_DEBUG_ROWS = 0;
+#endif
+
+    // The board, jump and obstacle settings a BasicGame is built with. Other configurations can
+    // derive from this and hide whichever values they want to change.
+    struct GameConfig
+    {
+        static constexpr int TILE_ROWS = 32;
+        static constexpr int TILE_COLS = 80;
+        static constexpr int PLAYER_POSITION = 20;
+
+        // Player jump settings. Height and distance should be odd and greater than 3.
+        static constexpr int PLAYER_JUMP_DISTANCE = 11;
+        static constexpr int PLAYER_JUMP_HEIGHT = 5;
+
+        // Obstacles
+        static constexpr int MIN_OBSTACLE_HEIGHT = 1;
+        static constexpr int MAX_OBSTACLE_HEIGHT = PLAYER_JUMP_HEIGHT - 1;
+        static constexpr int MIN_OBSTACLE_GAP = 11;
+        static constexpr int MAX_OBSTACLE_GAP = 80;
+        static constexpr int OBSTACLE_CREATION_CHANCE = 25;
+    };
+
+    // Symbols
+    const char EMPTY_SYMBOL = ' ';
+    const char WALL_SYMBOl = 'W';
+    const char PLAYER_SYMBOL_ASCENDING = '/';
+    const char PLAYER_SYMBOL_DESCENDING = '\\';
+    const char PLAYER_SYMBOL_FORWARD = '-';
+    const char PLAYER_SYMBOL_HEAD = '>';
+    const char PLAYER_SYMBOL_JUMP_TOP = '_';
+    const vector<char> OBSTACLE_SYMBOLS = {'#', '+', '?', '!'};
+    const string INSTRUCTIONS = "SPACE TO JUMP. ESC TO QUIT.";
+
+    // From: https://stackoverflow.com/a/52895729/11628429
+    inline void ClearConsole()
+    {
+#if defined _WIN32
+        system("cls");
+        //clrscr(); // including header file : conio.h
+#elif defined(__LINUX__) || defined(__gnu_linux__) || defined(__linux__)
+        system("clear");
+        //std::cout<< u8"\033[2J\033[1;1H"; //Using ANSI Escape Sequences
+#elif defined(__APPLE__)
+        system("clear");
+#endif
+    }
+
+    struct GameOptions
+    {
+        // Clears the screen and reprints every tile each frame instead of drawing only what changed
+        bool useLegacyRenderer = false;
+
+        // Polls kbhit() every GAME_LEGACY_INPUT_POLL_MS instead of waiting for stdin to be readable
+        bool useLegacyInput = false;
+
+        // Milliseconds between frames, 0 draws a frame after every batch of ticks
+        int renderInterval = 0;
+
+        // Draws frames on their own thread so a slow terminal can't hold up the game
+        bool useRenderThread = false;
+
+        // Draws tiles in color. Only the diff renderer uses colors.
+        bool useColor = true;
+
+        // Ticks between each obstacle picking new glyphs, 0 keeps the ones it spawned with.
+        // Obstacles take turns so only some of them change on any one tick.
+        int shimmerInterval = 0;
+
+        // Starts with stage timings being recorded and shown. P turns them on and off while playing.
+        bool isProfiling = false;
+
+        // Games with the same seed get the same obstacles
+        uint64_t seed = RandomSeed();
+
+        // Keeps a Replay of the game that GetRecording() returns
+        bool isRecording = false;
+
+        // Plays the jumps from this replay, which has to outlive the game, instead of the
+        // player's. Its seed and difficulty aren't applied, so set them to match.
+        const Replay *playback = nullptr;
+
+        // How many times faster than normal a replay is shown by Run()
+        double playbackSpeed = 1;
+
+        // Also gets every frame, to stream to anyone watching. Has to outlive the game.
+        SpectatorServer *spectators = nullptr;
+
+        // Brings obstacles closer together as the score rises
+        DifficultyCurve difficulty;
+
+        // Plays these obstacles before generating any, which has to outlive the game. Replays
+        // only keep its hash, so it has to be given again to play one back.
+        const Level *level = nullptr;
+    };
+
+    template <typename Config = GameConfig>
+    class BasicGame
+    {
+    public:
+        typedef BasicLevelStream<Config> LevelType;
+
+        static constexpr int TILE_ROWS = Config::TILE_ROWS;
+        static constexpr int TILE_COLS = Config::TILE_COLS;
+        static constexpr int PLAYER_POSITION = Config::PLAYER_POSITION;
+        static constexpr int PLAYER_JUMP_DISTANCE = Config::PLAYER_JUMP_DISTANCE;
+        static constexpr int PLAYER_JUMP_HEIGHT = Config::PLAYER_JUMP_HEIGHT;
+        static constexpr int PLAYER_JUMP_STEPS = PLAYER_JUMP_DISTANCE / 2; // Intentional integer division
+        static constexpr int MIN_OBSTACLE_HEIGHT = Config::MIN_OBSTACLE_HEIGHT;
+        static constexpr int MAX_OBSTACLE_HEIGHT = Config::MAX_OBSTACLE_HEIGHT;
+        static constexpr int MIN_OBSTACLE_GAP = Config::MIN_OBSTACLE_GAP;
+        static constexpr int HARDEST_OBSTACLE_GAP = LevelType::HARDEST_OBSTACLE_GAP;
+        static constexpr int MAX_OBSTACLE_GAP = Config::MAX_OBSTACLE_GAP;
+        static constexpr int OBSTACLE_CREATION_CHANCE = Config::OBSTACLE_CREATION_CHANCE;
+
+        // The score goes above the tiles with the instructions and any debug output below them
+        static constexpr int FRAME_ROWS = TILE_ROWS + 2 + GAME_DEBUG_ROWS;
+
+        // Obstacles spawn more than HARDEST_OBSTACLE_GAP columns apart, so only this many fit on the board
+        static constexpr int MAX_OBSTACLES = TILE_COLS / (HARDEST_OBSTACLE_GAP + 1) + 1;
+
+        static_assert(TILE_ROWS <= 32, "The rows the player has crashed into are stored as bits in a uint32_t");
+        static_assert(PLAYER_POSITION > 0 && PLAYER_POSITION < TILE_COLS, "The player has to be on the board with room for its trail");
+        static_assert(PLAYER_JUMP_DISTANCE > 3 && PLAYER_JUMP_DISTANCE % 2 == 1, "The jump distance should be odd and greater than 3");
+        static_assert(PLAYER_JUMP_HEIGHT > 3 && PLAYER_JUMP_HEIGHT % 2 == 1, "The jump height should be odd and greater than 3");
+        static_assert(PLAYER_JUMP_HEIGHT <= TILE_ROWS - 2, "The top of a jump has to be on the board");
+        static_assert(MIN_OBSTACLE_HEIGHT > 0 && MIN_OBSTACLE_HEIGHT <= MAX_OBSTACLE_HEIGHT, "Obstacle heights need to be a valid range");
+        static_assert(MAX_OBSTACLE_HEIGHT <= TILE_ROWS - 1, "Obstacles have to fit above the wall");
+        static_assert(MIN_OBSTACLE_GAP >= 0 && MIN_OBSTACLE_GAP <= MAX_OBSTACLE_GAP, "Obstacle gaps need to be a valid range");
+
+        BasicGame(GameOptions options = GameOptions())
+            : options(options), level(options.seed, options.difficulty, options.level), glyphRandom(options.seed, GLYPH_RANDOM_STREAM)
+        {
+            recording.seed = options.seed;
+            recording.pointsPerStep = options.difficulty.pointsPerStep;
+            // Hashing goes over the whole level, so it's skipped unless the replay will be saved
+            if (options.isRecording && options.level)
+                recording.levelHash = options.level->GetHash();
+        }
+
+        void Run()
+        {
+            if (isGameRunning)
+                throw "We're already running.";
+
+            isGameRunning = true;
+            profiler.SetEnabled(options.isProfiling);
+            if (!options.useLegacyInput)
+                input.reset(new ConsoleInput());
+            resizeWatcher.reset(new TerminalResizeWatcher());
+
+            if (options.useLegacyRenderer)
+            {
+                rlutil::hidecursor();
+                cout.flush();
+            }
+            else
+            {
+                renderer.Start();
+                if (options.useRenderThread)
+                    StartRenderThread();
+            }
+
+            // Ticks, frames and input take turns on this thread, each waking up exactly when
+            // it has something to do
+            // Chunks of obstacles are made ahead of time on another thread while we wait
+            level.StartPrefetch();
+            TaskScheduler scheduler;
+            TaskEvent ticksPlayed(scheduler);
+            Task inputTask = ReadInput(scheduler);
+            Task frameTask = DrawFrames(ticksPlayed);
+            Task tickTask = PlayTicks(scheduler, ticksPlayed);
+            scheduler.Spawn(inputTask);
+            scheduler.Spawn(frameTask);
+            scheduler.Run(tickTask);
+            level.StopPrefetch();
+
+            recording.endTick = tickCount;
+
+            if (options.useLegacyRenderer)
+            {
+                rlutil::showcursor();
+            }
+            else
+            {
+                StopRenderThread();
+                renderer.Finish();
+            }
+
+            resizeWatcher.reset();
+            input.reset();
+        }
+
+        // Advances the game by one tick without drawing anything or waiting.
+        // Returns false once the player has crashed.
+        bool Step()
+        {
+            Tick();
+            return !isPlayerColliding;
+        }
+
+        void PressJump()
+        {
+            if (options.isRecording)
+                recording.RecordJump(tickCount);
+
+            // A press during a jump starts the next jump as soon as we land
+            if (isJumping)
+                isJumpBuffered = true;
+            else
+                isJumping = true;
+        }
+
+        bool IsJumping() const
+        {
+            return isJumping;
+        }
+
+        int GetScore() const
+        {
+            return score;
+        }
+
+        long long GetTickCount() const
+        {
+            return tickCount;
+        }
+
+        const Profiler &GetProfiler() const
+        {
+            return profiler;
+        }
+
+        const Replay &GetRecording() const
+        {
+            return recording;
+        }
+
+        // How the game has gone so far, to be kept in a ScoreLog
+        ScoreRecord GetScoreRecord()
+        {
+            ScoreRecord record;
+            record.endTime = (int64_t)std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            record.seed = options.seed;
+            record.ticks = tickCount;
+            record.frames = frameCount;
+            record.droppedTicks = droppedTicks;
+            record.droppedFrames = droppedFrames;
+            record.droppedInputEvents = droppedInputEvents;
+            record.score = score;
+
+            for (size_t stage = 0; stage < (size_t)ProfileStage::Count; stage++)
+            {
+                ProfileSummary summary = profiler.GetSummary((ProfileStage)stage);
+                record.isProfiled |= summary.count > 0;
+                record.stageP50[stage] = (float)summary.p50;
+                record.stageP99[stage] = (float)summary.p99;
+            }
+            return record;
+        }
+
+        // True once a replay being played back has reached the tick its game ended on
+        bool IsPlaybackFinished() const
+        {
+            return options.playback && tickCount >= options.playback->endTick;
+        }
+
+        // How high above the ground the player is on the given step of a jump
+        static int GetJumpHeight(int step)
+        {
+            return JUMP_TRAJECTORY[step].height;
+        }
+
+        // Columns between the player and the closest obstacle ahead of them, or -1 if there isn't one
+        int GetDistanceToNextObstacle() const
+        {
+            for (int i = 0; i < obstacleCount; i++)
+            {
+                int col = GetObstacleColumn(GetObstacle(i));
+                if (col > PLAYER_POSITION)
+                    return col - PLAYER_POSITION;
+            }
+            return -1;
+        }
+
+        // Fills in the columns between the player and each obstacle ahead of them, closest first,
+        // along with their heights. Returns how many there were, up to capacity.
+        int GetObstaclesAhead(int *distances, int *heights, int capacity) const
+        {
+            int count = 0;
+            for (int i = 0; i < obstacleCount && count < capacity; i++)
+            {
+                const Obstacle &obstacle = GetObstacle(i);
+                int col = GetObstacleColumn(obstacle);
+                if (col <= PLAYER_POSITION)
+                    continue;
+
+                distances[count] = col - PLAYER_POSITION;
+                heights[count] = obstacle.height;
+                count++;
+            }
+            return count;
+        }
+
+    protected:
+        enum class Tile : uint8_t
+        {
+            Empty,
+            Wall,
+            Obstacle,
+            PlayerHead,
+            PlayerAscending,
+            PlayerDescending,
+            PlayerForward,
+            PlayerJumpTop
+        };
+
+        // Indexed by Tile. Obstacles get one of OBSTACLE_SYMBOLS instead.
+        static constexpr array<char, 8> TILE_GLYPHS = {
+            EMPTY_SYMBOL,
+            WALL_SYMBOl,
+            EMPTY_SYMBOL,
+            PLAYER_SYMBOL_HEAD,
+            PLAYER_SYMBOL_ASCENDING,
+            PLAYER_SYMBOL_DESCENDING,
+            PLAYER_SYMBOL_FORWARD,
+            PLAYER_SYMBOL_JUMP_TOP};
+        static_assert(TILE_GLYPHS.size() == (size_t)Tile::PlayerJumpTop + 1, "Every tile needs a glyph");
+
+        // Indexed by Tile
+        static constexpr array<uint8_t, 8> TILE_COLORS = {
+            DEFAULT_COLOR,
+            rlutil::BROWN,
+            rlutil::LIGHTRED,
+            rlutil::YELLOW,
+            rlutil::LIGHTCYAN,
+            rlutil::LIGHTCYAN,
+            rlutil::LIGHTCYAN,
+            rlutil::LIGHTCYAN};
+        static_assert(TILE_COLORS.size() == TILE_GLYPHS.size(), "Every tile needs a color");
+
+        struct Obstacle
+        {
+            // Counted from the left edge of the board on the tick scrollCount was 0
+            long long column;
+            int height;
+
+            // Bit n is set when the player's head has crashed into row n
+            uint32_t hitRows;
+
+            // Picked when it spawns, from the bottom up
+            array<char, MAX_OBSTACLE_HEIGHT> glyphs;
+        };
+
+        // The part of the player's trail left in one column behind them
+        struct TrailTile
+        {
+            int row;
+            Tile tile;
+        };
+
+        struct JumpStep
+        {
+            int height;
+
+            // Left behind in the player's trail when they move on from this step
+            Tile trailingTile;
+        };
+
+        // Every step of a jump, worked out at compile time. The player rises for PLAYER_JUMP_STEPS
+        // steps, falls for as many again and lands back on step 0.
+        static constexpr array<JumpStep, PLAYER_JUMP_DISTANCE - 1> JUMP_TRAJECTORY = []() {
+            array<JumpStep, PLAYER_JUMP_DISTANCE - 1> trajectory = {};
+            for (int step = 0; step < PLAYER_JUMP_DISTANCE - 1; step++)
+            {
+                int rise = step <= PLAYER_JUMP_STEPS ? step : 2 * PLAYER_JUMP_STEPS - step;
+                trajectory[step].height = rise * PLAYER_JUMP_HEIGHT / PLAYER_JUMP_STEPS;
+
+                if (step < PLAYER_JUMP_STEPS)
+                    trajectory[step].trailingTile = Tile::PlayerAscending;
+                else if (step == PLAYER_JUMP_STEPS)
+                    trajectory[step].trailingTile = Tile::PlayerJumpTop;
+                else
+                    trajectory[step].trailingTile = Tile::PlayerDescending;
+            }
+            return trajectory;
+        }();
+
+        // Obstacle glyphs come from their own generator so they can't change how the game plays
+        static const uint64_t GLYPH_RANDOM_STREAM = 1;
+
+        GameOptions options;
+        LevelType level;
+        Pcg32 glyphRandom;
+        DiffRenderer renderer;
+        Profiler profiler;
+        Replay recording;
+        size_t nextPlaybackJump = 0;
+        Frame frame{FRAME_ROWS, TILE_COLS};
+
+        // The part of frame that fits in the terminal, only used when all of it doesn't
+        std::unique_ptr<TerminalResizeWatcher> resizeWatcher;
+        Frame viewport{0, 0};
+        int viewportCol = 0;
+        bool isViewportCropped = false;
+
+        // Frames are passed to the render thread, when it's used, through renderFrames. Anything
+        // it draws with belongs to it while it runs.
+        thread renderThread;
+        std::unique_ptr<TripleBuffer<Frame>> renderFrames;
+        std::mutex renderMutex;
+        std::condition_variable renderWake;
+        atomic<bool> isRendering{false};
+
+        int score = 0;
+        long long tickCount = 0;
+        long long frameCount = 0;
+        long long droppedTicks = 0;
+        long long droppedFrames = 0;
+#if DEBUG
+        // Heap allocations since the frame before, which should be none once the game is going
+        long long lastAllocationCount = 0;
+        long long frameAllocations = 0;
+#endif
+        int playerSymbolIndex = 0;
+
+        // The obstacles on the board from left to right, kept in a ring starting at firstObstacle.
+        // The board itself is only ever built as tiles when a frame is drawn.
+        array<Obstacle, MAX_OBSTACLES> obstacles = {};
+        int firstObstacle = 0;
+        int obstacleCount = 0;
+        long long scrollCount = 0;
+
+        // One tile for each column left of the player, in a ring starting at firstTrailTile
+        array<TrailTile, PLAYER_POSITION> trail = {};
+        int firstTrailTile = 0;
+        int playerRow = TILE_ROWS - 2;
+
+        int prevStepCount = 0;
+        int jumpStepCount = 0;
+
+        SpscQueue<InputEvent, GAME_INPUT_QUEUE_SIZE> inputEvents;
+        long long droppedInputEvents = 0;
+        std::chrono::steady_clock::duration lastInputLatency = {};
+        std::unique_ptr<ConsoleInput> input;
+        bool isGameRunning = false;
+        bool isJumping = false;
+        bool isJumpBuffered = false;
+        bool isPlayerColliding = false;
+
+        void Tick()
+        {
+            // The order of these operations is important.
+            // The actions taken are designed to be done in a specific order.
+            if (options.playback)
+                PlayBackJumps();
+            ProcessInputEvents();
+            {
+                ProfileScope scope(profiler, ProfileStage::Update, tickCount);
+                UpdateScore();
+                UpdatePlayerPosition();
+            }
+            {
+                ProfileScope scope(profiler, ProfileStage::Collision, tickCount);
+                UpdateTilesAndCheckForCollisions();
+            }
+            {
+                ProfileScope scope(profiler, ProfileStage::ObstacleSpawn, tickCount);
+                UpdateObstacles();
+                if (options.shimmerInterval > 0)
+                    ShimmerObstacles();
+            }
+            tickCount++;
+        }
+
+        // Keys are queued as they come in and handled at the start of the next tick
+        void QueueKey(int key)
+        {
+            if (inputEvents.TryPush({key, std::chrono::steady_clock::now()}))
+                return;
+
+            droppedInputEvents++;
+
+            // Quitting shouldn't depend on there being room in the queue
+            if (key == rlutil::KEY_ESCAPE)
+                isGameRunning = false;
+        }
+
+        void ProcessInputEvents()
+        {
+            InputEvent event;
+            while (inputEvents.TryPop(event))
+            {
+                switch (event.key)
+                {
+                case rlutil::KEY_SPACE:
+                {
+                    // Replays can be watched but not played
+                    if (options.playback)
+                        break;
+
+                    PressJump();
+
+                    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                    lastInputLatency = now - event.time;
+                    if (profiler.IsEnabled())
+                        profiler.Record(ProfileStage::InputLatency, tickCount, event.time, now);
+                    break;
+                }
+                case 'p':
+                case 'P':
+                    profiler.SetEnabled(!profiler.IsEnabled());
+                    break;
+                case rlutil::KEY_ESCAPE:
+                    isGameRunning = false;
+                    break;
+                }
+            }
+        }
+
+        // Presses jump on the same ticks the player did in the replay
+        void PlayBackJumps()
+        {
+            const vector<long long> &jumpTicks = options.playback->jumpTicks;
+            while (nextPlaybackJump < jumpTicks.size() && jumpTicks[nextPlaybackJump] <= tickCount)
+            {
+                PressJump();
+                nextPlaybackJump++;
+            }
+        }
+
+        // Plays ticks as they come due until the game is over, waking the frame task after each batch
+        Task PlayTicks(TaskScheduler &scheduler, TaskEvent &ticksPlayed)
+        {
+            std::chrono::duration<double, std::milli> tickLength(GAME_SPEED);
+            if (options.playback && options.playbackSpeed > 0)
+                tickLength /= options.playbackSpeed;
+
+            FixedTimestep timestep(std::chrono::duration_cast<FixedTimestep::Clock::duration>(tickLength), GAME_MAX_CATCH_UP_TICKS);
+            timestep.Start();
+
+            while (isGameRunning)
+            {
+                co_await scheduler.SleepUntil(timestep.NextTickTime());
+
+                int dueTicks = timestep.Advance();
+                for (int i = 0; i < dueTicks && !isPlayerColliding && !IsPlaybackFinished(); i++)
+                {
+                    Tick();
+                }
+
+                if (dueTicks > 0)
+                    ticksPlayed.Set();
+
+                if (isPlayerColliding || IsPlaybackFinished())
+                    isGameRunning = false;
+            }
+
+            droppedTicks = timestep.GetDroppedTicks();
+        }
+
+        // Draws the first frame and then one after ticks are played, as long as renderInterval
+        // has passed since the last one. The frame the player crashed on is always drawn.
+        Task DrawFrames(TaskEvent &ticksPlayed)
+        {
+            std::chrono::milliseconds renderInterval(options.renderInterval);
+            FixedTimestep::Clock::time_point nextRenderTime = FixedTimestep::Clock::now();
+            PrintGameState();
+
+            while (true)
+            {
+                co_await ticksPlayed;
+
+                FixedTimestep::Clock::time_point now = FixedTimestep::Clock::now();
+                if (now < nextRenderTime && !isPlayerColliding)
+                    continue;
+
+                PrintGameState();
+                frameCount++;
+                nextRenderTime = std::max(nextRenderTime + renderInterval, now);
+            }
+        }
+
+        Task ReadInput(TaskScheduler &scheduler)
+        {
+            if (options.useLegacyInput)
+            {
+                while (true)
+                {
+                    while (kbhit())
+                    {
+                        QueueKey(rlutil::getkey());
+                    }
+                    co_await scheduler.SleepUntil(TaskScheduler::Clock::now() + std::chrono::milliseconds(GAME_LEGACY_INPUT_POLL_MS));
+                }
+            }
+
+            int key;
+            while (!input->IsClosed())
+            {
+                co_await scheduler.WaitForInput();
+                while (input->ReadKey(key))
+                {
+                    QueueKey(key);
+                }
+            }
+        }
+
+        // The i-th obstacle from the left
+        Obstacle &GetObstacle(int i)
+        {
+            int index = firstObstacle + i;
+            return obstacles[index >= MAX_OBSTACLES ? index - MAX_OBSTACLES : index];
+        }
+
+        const Obstacle &GetObstacle(int i) const
+        {
+            return const_cast<BasicGame *>(this)->GetObstacle(i);
+        }
+
+        int GetObstacleColumn(const Obstacle &obstacle) const
+        {
+            return (int)(obstacle.column - scrollCount);
+        }
+
+        // The obstacle in the given column, or nullptr if there isn't one
+        Obstacle *FindObstacle(int col)
+        {
+            for (int i = 0; i < obstacleCount; i++)
+            {
+                Obstacle &obstacle = GetObstacle(i);
+                int obstacleCol = GetObstacleColumn(obstacle);
+                if (obstacleCol >= col)
+                    return obstacleCol == col ? &obstacle : nullptr;
+            }
+            return nullptr;
+        }
+
+        // Obstacles fill their column from just above the wall up to their height
+        static bool IsObstacleRow(const Obstacle &obstacle, int row)
+        {
+            return row >= TILE_ROWS - 1 - obstacle.height && row <= TILE_ROWS - 2 && !((obstacle.hitRows >> row) & 1);
+        }
+
+        bool IsObstacle(int row, int col)
+        {
+            Obstacle *obstacle = FindObstacle(col);
+            return obstacle && IsObstacleRow(*obstacle, row);
+        }
+
+        TrailTile &GetTrailTile(int col)
+        {
+            int index = firstTrailTile + col;
+            return trail[index >= PLAYER_POSITION ? index - PLAYER_POSITION : index];
+        }
+
+        Tile GetTrailingPlayerTile()
+        {
+            // Jumps never land on the step after they start, so this only holds when we didn't jump
+            if (prevStepCount == 0 && jumpStepCount == 0)
+                return Tile::PlayerForward;
+
+            return JUMP_TRAJECTORY[prevStepCount].trailingTile;
+        }
+
+        void UpdateTilesAndCheckForCollisions()
+        {
+            // Move everything one column to the left and forget the obstacle that falls off the
+            // left edge. The oldest part of the trail is reused for the column the head just left.
+            scrollCount++;
+            if (obstacleCount > 0 && GetObstacleColumn(GetObstacle(0)) < 0)
+            {
+                firstObstacle = firstObstacle == MAX_OBSTACLES - 1 ? 0 : firstObstacle + 1;
+                obstacleCount--;
+            }
+
+            firstTrailTile = firstTrailTile == PLAYER_POSITION - 1 ? 0 : firstTrailTile + 1;
+            GetTrailTile(PLAYER_POSITION - 1) = {playerRow, GetTrailingPlayerTile()};
+
+            playerRow = TILE_ROWS - 2 - GetJumpHeight(jumpStepCount);
+
+            // The head replaces whatever it lands on
+            Obstacle *obstacle = FindObstacle(PLAYER_POSITION);
+            isPlayerColliding = obstacle && IsObstacleRow(*obstacle, playerRow);
+            if (isPlayerColliding)
+                obstacle->hitRows |= 1u << playerRow;
+        }
+
+        void UpdatePlayerPosition()
+        {
+            prevStepCount = jumpStepCount;
+
+            if (!isJumping)
+                return;
+
+            jumpStepCount++;
+
+            if (jumpStepCount == PLAYER_JUMP_DISTANCE - 1)
+            {
+                jumpStepCount = 0;
+                isJumping = isJumpBuffered;
+                isJumpBuffered = false;
+            }
+        }
+
+        void UpdateScore()
+        {
+            // The player gets 1 point each time they jump over an obstacle
+            score += IsObstacle(TILE_ROWS - 2, PLAYER_POSITION);
+        }
+
+        void UpdateObstacles()
+        {
+            int height = level.NextColumn();
+            if (height == 0)
+                return;
+
+            Obstacle &obstacle = GetObstacle(obstacleCount);
+            obstacle = {scrollCount + TILE_COLS - 1, height, 0, {}};
+            PickObstacleGlyphs(obstacle);
+            obstacleCount++;
+        }
+
+        char GetPlayerSymbol()
+        {
+            return PLAYER_SYMBOL_HEAD;
+        }
+
+        uint8_t GetTileColor(Tile tile) const
+        {
+            return options.useColor ? TILE_COLORS[(uint8_t)tile] : DEFAULT_COLOR;
+        }
+
+        void PickObstacleGlyphs(Obstacle &obstacle)
+        {
+            for (int i = 0; i < obstacle.height; i++)
+            {
+                obstacle.glyphs[i] = OBSTACLE_SYMBOLS[glyphRandom.Below((uint32_t)OBSTACLE_SYMBOLS.size())];
+            }
+        }
+
+        // Each obstacle's turn comes round every shimmerInterval ticks, offset by the column it
+        // spawned in
+        void ShimmerObstacles()
+        {
+            for (int i = 0; i < obstacleCount; i++)
+            {
+                Obstacle &obstacle = GetObstacle(i);
+                if ((tickCount + obstacle.column) % options.shimmerInterval == 0)
+                    PickObstacleGlyphs(obstacle);
+            }
+        }
+
+#if DEBUG
+        void SetDebugLine(int &row, const char *format, ...)
+        {
+            char text[TILE_COLS + 1];
+            va_list args;
+            va_start(args, format);
+            int length = vsnprintf(text, sizeof(text), format, args);
+            va_end(args);
+            frame.SetText(row++, text, std::min(length, TILE_COLS));
+        }
+#endif
+
+        // Lists recent stage timings over the empty sky at the top of the board
+        void DrawProfileOverlay()
+        {
+            char text[TILE_COLS + 1];
+            int row = 2;
+
+            int length = snprintf(text, sizeof(text), "%-16s %10s %10s", "stage (us)", "p50", "p99");
+            SetOverlayText(row++, text, length);
+
+            for (size_t stage = 0; stage < (size_t)ProfileStage::Count && row <= TILE_ROWS; stage++)
+            {
+                ProfileSummary summary = profiler.GetSummary((ProfileStage)stage);
+                length = snprintf(text, sizeof(text), "%-16s %10.1f %10.1f", PROFILE_STAGE_NAMES[stage], summary.p50, summary.p99);
+                SetOverlayText(row++, text, length);
+            }
+        }
+
+        // Writes over the tiles from the second column without clearing the rest of the row
+        void SetOverlayText(int row, const char *text, int length)
+        {
+            length = std::min(length, TILE_COLS - 1);
+            memcpy(frame.Row(row) + 1, text, length);
+            memset(frame.Colors(row) + 1, DEFAULT_COLOR, length);
+        }
+
+        void BuildFrame()
+        {
+            char text[TILE_COLS + 1];
+            int length = snprintf(text, sizeof(text), "SCORE: %d", score);
+            frame.SetCenteredText(0, text, std::min(length, TILE_COLS));
+
+            // Tile row n is frame row n + 1
+            for (int row = 1; row < TILE_ROWS; row++)
+            {
+                frame.FillRow(row, TILE_GLYPHS[(uint8_t)Tile::Empty], GetTileColor(Tile::Empty));
+            }
+            frame.FillRow(TILE_ROWS, TILE_GLYPHS[(uint8_t)Tile::Wall], GetTileColor(Tile::Wall));
+
+            // Rows the head crashed into are covered by the player, so they're left out
+            uint8_t obstacleColor = GetTileColor(Tile::Obstacle);
+            for (int i = 0; i < obstacleCount; i++)
+            {
+                const Obstacle &obstacle = GetObstacle(i);
+                int col = GetObstacleColumn(obstacle);
+                for (int row = TILE_ROWS - 1 - obstacle.height; row <= TILE_ROWS - 2; row++)
+                {
+                    if (IsObstacleRow(obstacle, row))
+                        frame.SetCell(row + 1, col, obstacle.glyphs[TILE_ROWS - 2 - row], obstacleColor);
+                }
+            }
+
+            for (int col = 0; col < PLAYER_POSITION; col++)
+            {
+                const TrailTile &trailTile = GetTrailTile(col);
+                if (trailTile.tile != Tile::Empty)
+                    frame.SetCell(trailTile.row + 1, col, TILE_GLYPHS[(uint8_t)trailTile.tile], GetTileColor(trailTile.tile));
+            }
+            frame.SetCell(playerRow + 1, PLAYER_POSITION, TILE_GLYPHS[(uint8_t)Tile::PlayerHead], GetTileColor(Tile::PlayerHead));
+
+            if (profiler.IsEnabled())
+                DrawProfileOverlay();
+
+            frame.SetCenteredText(TILE_ROWS + 1, INSTRUCTIONS.data(), (int)INSTRUCTIONS.size());
+
+#if DEBUG
+            int row = TILE_ROWS + 2;
+            SetDebugLine(row, "seed: %llu", (unsigned long long)options.seed);
+            SetDebugLine(row, "score: %d", score);
+            SetDebugLine(row, "playerHeight: %d", GetJumpHeight(jumpStepCount));
+            SetDebugLine(row, "jumpStepCount: %d", jumpStepCount);
+            SetDebugLine(row, "prevStepCount: %d", prevStepCount);
+            SetDebugLine(row, "isPlayerColliding: %d", isPlayerColliding);
+            SetDebugLine(row, "tickCount: %lld", tickCount);
+            SetDebugLine(row, "frameCount: %lld", frameCount);
+            SetDebugLine(row, "droppedTicks: %lld", droppedTicks);
+            SetDebugLine(row, "droppedFrames: %lld", droppedFrames);
+            SetDebugLine(row, "droppedInputEvents: %lld", droppedInputEvents);
+            SetDebugLine(row, "frameAllocations: %lld", frameAllocations);
+            SetDebugLine(row, "lastInputLatencyUs: %lld", (long long)std::chrono::duration_cast<std::chrono::microseconds>(lastInputLatency).count());
+#endif
+        }
+
+        // Works out how much of the frame fits in the terminal, keeping the score, the ground and
+        // the player in view. Only called after the terminal reports a resize.
+        void UpdateViewport()
+        {
+            TerminalSize size;
+            if (!GetTerminalSize(size))
+            {
+                isViewportCropped = false;
+                return;
+            }
+
+            int rows = std::min(size.rows, FRAME_ROWS);
+            int cols = std::min(size.cols, TILE_COLS);
+            isViewportCropped = rows < FRAME_ROWS || cols < TILE_COLS;
+
+            if (viewport.GetRows() != rows || viewport.GetCols() != cols)
+                viewport = Frame(rows, cols);
+
+            viewportCol = std::max(0, std::min(PLAYER_POSITION - cols / 4, TILE_COLS - cols));
+        }
+
+        // The score row stays at the top and the rest is taken from the bottom of the frame
+        void CopyViewport(const Frame &source)
+        {
+            int cols = viewport.GetCols();
+            int centeredCol = (TILE_COLS - cols) / 2;
+
+            for (int row = 0; row < viewport.GetRows(); row++)
+            {
+                int frameRow = row == 0 ? 0 : FRAME_ROWS - viewport.GetRows() + row;
+
+                int col = 0;
+                if (frameRow == 0 || frameRow == TILE_ROWS + 1)
+                    col = centeredCol;
+                else if (frameRow <= TILE_ROWS)
+                    col = viewportCol;
+
+                memcpy(viewport.Row(row), source.Row(frameRow) + col, cols);
+                memcpy(viewport.Colors(row), source.Colors(frameRow) + col, cols);
+            }
+        }
+
+        void DrawFrame(const Frame &source)
+        {
+            if (resizeWatcher && resizeWatcher->HasResized())
+                UpdateViewport();
+
+            if (isViewportCropped)
+            {
+                CopyViewport(source);
+                renderer.Draw(viewport);
+            }
+            else
+            {
+                renderer.Draw(source);
+            }
+        }
+
+        void StartRenderThread()
+        {
+            renderFrames.reset(new TripleBuffer<Frame>(frame));
+            isRendering = true;
+
+            renderThread = thread([this]() {
+                while (true)
+                {
+                    {
+                        std::unique_lock<std::mutex> lock(renderMutex);
+                        renderWake.wait(lock, [this]() { return renderFrames->HasUpdate() || !isRendering; });
+                    }
+
+                    // Whatever was published last still gets drawn before stopping
+                    if (renderFrames->Update())
+                        DrawFrame(renderFrames->GetReadBuffer());
+                    else if (!isRendering)
+                        break;
+                }
+            });
+        }
+
+        void StopRenderThread()
+        {
+            if (!renderThread.joinable())
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(renderMutex);
+                isRendering = false;
+            }
+            renderWake.notify_one();
+
+            renderThread.join();
+            renderFrames.reset();
+        }
+
+        // Hands a copy of the frame to the render thread, replacing any it hasn't drawn yet
+        void PublishFrame()
+        {
+            renderFrames->GetWriteBuffer() = frame;
+            droppedFrames += !renderFrames->Publish();
+
+            // Taking the lock means the render thread is either waiting or hasn't checked yet
+            {
+                std::lock_guard<std::mutex> lock(renderMutex);
+            }
+            renderWake.notify_one();
+        }
+
+        void PrintGameState()
+        {
+#if DEBUG
+            long long allocationCount = GetAllocationCount();
+            frameAllocations = allocationCount - lastAllocationCount;
+            lastAllocationCount = allocationCount;
+#endif
+
+            {
+                ProfileScope scope(profiler, ProfileStage::FrameBuild, tickCount);
+                BuildFrame();
+            }
+
+            // With a render thread this is only the cost of handing the frame over
+            ProfileScope scope(profiler, ProfileStage::Output, tickCount);
+
+            if (options.spectators)
+                options.spectators->Publish(frame);
+
+            if (!options.useLegacyRenderer)
+            {
+                if (renderThread.joinable())
+                    PublishFrame();
+                else
+                    DrawFrame(frame);
+                return;
+            }
+
+            ClearConsole();
+            for (int row = 0; row < frame.GetRows(); row++)
+            {
+                cout.write(frame.Row(row), frame.GetCols()) << '\n';
+            }
+            cout.flush();
+        }
+    };
+
+    typedef BasicGame<> Game;
+} // namespace RunButLikeActually
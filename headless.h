@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <game.h>
+
+namespace RunButLikeActually
+{
+    const int SCRIPTED_JUMP_DISTANCE = 5;
+
+    // Stands in for a player by jumping as soon as the next obstacle is jumpDistance columns away
+    struct ScriptedPolicy
+    {
+        int jumpDistance = SCRIPTED_JUMP_DISTANCE;
+
+        template <typename Config>
+        void operator()(BasicGame<Config> &game) const
+        {
+            if (!game.IsJumping() && game.GetDistanceToNextObstacle() == jumpDistance)
+                game.PressJump();
+        }
+    };
+
+    struct HeadlessStats
+    {
+        long long ticks = 0;
+        long long games = 0;
+        long long totalScore = 0;
+        int bestScore = 0;
+        double seconds = 0;
+
+        double TicksPerSecond() const
+        {
+            return seconds > 0 ? ticks / seconds : 0;
+        }
+    };
+
+    // Plays games back to back, without a terminal or any waiting, until the given number of
+    // ticks have been simulated. Each game is played with options, but gets the next seed after
+    // the previous one.
+    template <typename Policy>
+    HeadlessStats RunHeadless(long long ticks, GameOptions options, Policy &policy)
+    {
+        HeadlessStats stats;
+        auto start = std::chrono::steady_clock::now();
+
+        uint64_t seed = options.seed;
+        while (stats.ticks < ticks)
+        {
+            options.seed = seed + stats.games;
+            Game game(options);
+
+            while (stats.ticks < ticks)
+            {
+                policy(game);
+                stats.ticks++;
+
+                if (!game.Step())
+                    break;
+            }
+
+            stats.games++;
+            stats.totalScore += game.GetScore();
+            stats.bestScore = std::max(stats.bestScore, game.GetScore());
+        }
+
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+
+    struct ReplayStats
+    {
+        long long ticks = 0;
+        int score = 0;
+        bool isColliding = false;
+        double seconds = 0;
+    };
+
+    // Plays a recorded game again without a terminal or any waiting, up to the tick it ended on.
+    // The replay only keeps a hash of the level, so options.level has to be the one it was played on.
+    inline ReplayStats RunReplay(const Replay &replay, GameOptions options = GameOptions())
+    {
+        options.seed = replay.seed;
+        options.difficulty.pointsPerStep = replay.pointsPerStep;
+        options.playback = &replay;
+        Game game(options);
+
+        ReplayStats stats;
+        auto start = std::chrono::steady_clock::now();
+
+        while (!game.IsPlaybackFinished())
+        {
+            if (!game.Step())
+            {
+                stats.isColliding = true;
+                break;
+            }
+        }
+
+        stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        stats.ticks = game.GetTickCount();
+        stats.score = game.GetScore();
+        return stats;
+    }
+} // namespace RunButLikeActually
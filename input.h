@@ -0,0 +1,205 @@
+#pragma once
+
+#include <chrono>
+#include <rlutil.h>
+#include <terminal.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+namespace RunButLikeActually
+{
+    const int KEY_NONE = -1;
+
+    struct InputEvent
+    {
+        int key;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    // Reads key presses from stdin once something is waiting there, which a TaskScheduler can
+    // wait for. The terminal is switched to unbuffered, no echo mode once for as long as this
+    // object lives.
+    class ConsoleInput
+    {
+    public:
+        ConsoleInput()
+        {
+#ifdef _WIN32
+            inputHandle = GetStdHandle(STD_INPUT_HANDLE);
+            hasSavedMode = GetConsoleMode(inputHandle, &savedMode);
+            if (hasSavedMode)
+                SetConsoleMode(inputHandle, (savedMode & ~(ENABLE_LINE_INPUT | ENABLE_ECHO_INPUT)) | ENABLE_WINDOW_INPUT);
+#else
+            hasSavedMode = tcgetattr(STDIN_FILENO, &savedMode) == 0;
+            if (hasSavedMode)
+            {
+                struct termios raw = savedMode;
+                raw.c_lflag &= ~(ICANON | ECHO);
+                raw.c_cc[VMIN] = 1;
+                raw.c_cc[VTIME] = 0;
+                tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+            }
+#endif
+        }
+
+        ~ConsoleInput()
+        {
+#ifdef _WIN32
+            if (hasSavedMode)
+                SetConsoleMode(inputHandle, savedMode);
+#else
+            if (hasSavedMode)
+                tcsetattr(STDIN_FILENO, TCSANOW, &savedMode);
+#endif
+        }
+
+        ConsoleInput(const ConsoleInput &) = delete;
+        ConsoleInput &operator=(const ConsoleInput &) = delete;
+
+        // Stores the rlutil key code of a key press that's waiting, or KEY_NONE for input we
+        // don't recognise, without blocking. Returns false once there's nothing left to read.
+        bool ReadKey(int &key)
+        {
+#ifdef _WIN32
+            // Console input includes focus and mouse events, which are read and skipped
+            while (Poll())
+            {
+                INPUT_RECORD record;
+                DWORD count = 0;
+                if (!ReadConsoleInputA(inputHandle, &record, 1, &count))
+                {
+                    isClosed = true;
+                    return false;
+                }
+
+                if (count > 0 && record.EventType == WINDOW_BUFFER_SIZE_EVENT)
+                    TerminalResizeWatcher::NotifyResized();
+
+                if (count == 0 || record.EventType != KEY_EVENT || !record.Event.KeyEvent.bKeyDown)
+                    continue;
+
+                switch (record.Event.KeyEvent.wVirtualKeyCode)
+                {
+                case VK_ESCAPE:
+                    key = rlutil::KEY_ESCAPE;
+                    break;
+                case VK_SPACE:
+                    key = rlutil::KEY_SPACE;
+                    break;
+                default:
+                    key = record.Event.KeyEvent.uChar.AsciiChar ? record.Event.KeyEvent.uChar.AsciiChar : KEY_NONE;
+                    break;
+                }
+                return true;
+            }
+            return false;
+#else
+            if (!Poll())
+                return false;
+
+            unsigned char ch;
+            ssize_t length = read(STDIN_FILENO, &ch, 1);
+            if (length != 1)
+            {
+                isClosed = length == 0 || (errno != EINTR && errno != EAGAIN);
+                return false;
+            }
+
+            key = ch == 27 ? ReadEscapeSequence() : ch;
+            return true;
+#endif
+        }
+
+        // Returns true if a key press is waiting to be read, without blocking.
+        bool Poll()
+        {
+#ifdef _WIN32
+            return WaitForSingleObject(inputHandle, 0) == WAIT_OBJECT_0;
+#else
+            return WaitForInput(0);
+#endif
+        }
+
+        // Set once stdin has been closed, after which ReadKey() never finds anything
+        bool IsClosed() const
+        {
+            return isClosed;
+        }
+
+    private:
+        bool isClosed = false;
+
+#ifdef _WIN32
+        HANDLE inputHandle;
+        DWORD savedMode = 0;
+        BOOL hasSavedMode = FALSE;
+#else
+        struct termios savedMode;
+        bool hasSavedMode = false;
+
+        // Waits up to timeout milliseconds for stdin to become readable, or be closed. Stdin
+        // that can't be polled at all, because it isn't open or has failed, counts as closed.
+        bool WaitForInput(int timeout)
+        {
+            struct pollfd fd = {};
+            fd.fd = STDIN_FILENO;
+            fd.events = POLLIN;
+
+            while (true)
+            {
+                int result = poll(&fd, 1, timeout);
+                if (result < 0 && errno == EINTR)
+                    continue;
+
+                if (result < 0 || (fd.revents & (POLLERR | POLLNVAL)) != 0)
+                {
+                    isClosed = true;
+                    return false;
+                }
+                return result > 0 && (fd.revents & (POLLIN | POLLHUP)) != 0;
+            }
+        }
+
+        // A lone ESC is the escape key, anything that follows it straight away is a sequence
+        // such as an arrow key.
+        int ReadEscapeSequence()
+        {
+            unsigned char sequence[8];
+            ssize_t length = 0;
+
+            if (WaitForInput(0))
+                length = read(STDIN_FILENO, sequence, sizeof(sequence));
+
+            if (length <= 0)
+                return rlutil::KEY_ESCAPE;
+
+            if (length == 2 && sequence[0] == '[')
+            {
+                switch (sequence[1])
+                {
+                case 'A':
+                    return rlutil::KEY_UP;
+                case 'B':
+                    return rlutil::KEY_DOWN;
+                case 'C':
+                    return rlutil::KEY_RIGHT;
+                case 'D':
+                    return rlutil::KEY_LEFT;
+                }
+            }
+
+            return KEY_NONE;
+        }
+#endif
+    };
+} // namespace RunButLikeActually
@@ -0,0 +1,382 @@
+// Measures how long a SPACE press takes to show up on screen. Runs the game under a pseudo
+// terminal with an empty level, so nothing can end it early, presses SPACE and times how long it
+// takes for the first PLAYER_SYMBOL_ASCENDING to come out. Needs forkpty(), so it's only built
+// on POSIX systems.
+#include <game.h>
+#include <level.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <util.h>
+#else
+#include <pty.h>
+#endif
+
+namespace RunButLikeActually
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int LATENCY_PRESSES = 40;
+
+    // Presses that take longer than this to show up are counted as missed
+    const int LATENCY_TIMEOUT_MS = 1000;
+
+    const int LATENCY_STARTUP_TIMEOUT_MS = 5000;
+
+    // How long the output has to go without the player ascending before the next press, which
+    // is long enough for the last jump's trail to scroll off the board
+    const int LATENCY_SETTLE_MS = 150;
+
+    // Presses land up to this long after the game has settled, so they're spread over a tick
+    const int LATENCY_JITTER_US = GAME_SPEED * 1000;
+
+    const int LATENCY_TERMINAL_ROWS = 50;
+    const int LATENCY_TERMINAL_COLS = 120;
+
+    // Long enough that the game never gets to the generated obstacles after it
+    const size_t LATENCY_LEVEL_COLUMNS = 1 << 20;
+
+    // Finds PLAYER_SYMBOL_ASCENDING in what the game writes, skipping over escape sequences.
+    // Sequences can be split between reads, so where it's up to is kept between calls.
+    class AscendingScanner
+    {
+    public:
+        // Returns true if the symbol is drawn anywhere in data
+        bool Scan(const char *data, size_t length)
+        {
+            bool isFound = false;
+            for (size_t i = 0; i < length; i++)
+            {
+                char c = data[i];
+                switch (state)
+                {
+                case State::Text:
+                    if (c == '\x1b')
+                        state = State::Escape;
+                    else if (c == PLAYER_SYMBOL_ASCENDING)
+                        isFound = true;
+                    break;
+                case State::Escape:
+                    state = c == '[' ? State::Csi : State::Text;
+                    break;
+                case State::Csi:
+                    // Parameters and intermediate bytes come before the final byte
+                    if (c >= 0x40 && c <= 0x7e)
+                        state = State::Text;
+                    break;
+                }
+            }
+            return isFound;
+        }
+
+    private:
+        enum class State
+        {
+            Text,
+            Escape,
+            Csi
+        };
+
+        State state = State::Text;
+    };
+
+    // The game running under a pseudo terminal
+    class TerminalGame
+    {
+    public:
+        ~TerminalGame()
+        {
+            Stop();
+        }
+
+        // Returns once the game has drawn something, since the terminal isn't raw until then and
+        // a press would wait for the end of the line. Returns false if it never does.
+        bool Start(const std::string &binary, const std::vector<std::string> &args)
+        {
+            struct winsize size = {};
+            size.ws_row = LATENCY_TERMINAL_ROWS;
+            size.ws_col = LATENCY_TERMINAL_COLS;
+
+            pid = forkpty(&fd, NULL, NULL, &size);
+            if (pid < 0)
+                return false;
+
+            if (pid == 0)
+            {
+                std::vector<char *> argv;
+                argv.push_back((char *)binary.c_str());
+                for (const std::string &arg : args)
+                {
+                    argv.push_back((char *)arg.c_str());
+                }
+                argv.push_back(NULL);
+
+                // The legacy renderer runs clear, which needs to know what the terminal is
+                setenv("TERM", "xterm-256color", 0);
+                execvp(binary.c_str(), argv.data());
+                _exit(127);
+            }
+
+            struct pollfd pollFd = {};
+            pollFd.fd = fd;
+            pollFd.events = POLLIN;
+            char data[65536];
+            ssize_t length;
+            if (poll(&pollFd, 1, LATENCY_STARTUP_TIMEOUT_MS) <= 0 || (length = read(fd, data, sizeof(data))) <= 0)
+                return false;
+
+            scanner.Scan(data, (size_t)length);
+            return true;
+        }
+
+        // Asks the game to quit and waits for it
+        void Stop()
+        {
+            if (pid <= 0)
+                return;
+
+            const char escape = 27;
+            if (write(fd, &escape, 1) != 1 || !WaitForExit(LATENCY_TIMEOUT_MS))
+            {
+                kill(pid, SIGKILL);
+                waitpid(pid, NULL, 0);
+            }
+
+            close(fd);
+            fd = -1;
+            pid = -1;
+        }
+
+        bool Press(char key)
+        {
+            return write(fd, &key, 1) == 1;
+        }
+
+        // Reads whatever the game writes until the deadline. Returns true as soon as the player
+        // is drawn ascending, setting when, and false if it isn't by then or the game has exited.
+        bool WaitForAscending(Clock::time_point deadline, Clock::time_point &when)
+        {
+            char data[65536];
+            while (true)
+            {
+                long long timeoutMs = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now()).count();
+                if (timeoutMs <= 0)
+                    return false;
+
+                struct pollfd pollFd = {};
+                pollFd.fd = fd;
+                pollFd.events = POLLIN;
+                int result = poll(&pollFd, 1, (int)timeoutMs);
+                if (result < 0 && errno == EINTR)
+                    continue;
+                if (result <= 0)
+                    return false;
+
+                ssize_t length = read(fd, data, sizeof(data));
+                if (length <= 0)
+                    return false;
+
+                if (scanner.Scan(data, (size_t)length))
+                {
+                    when = Clock::now();
+                    return true;
+                }
+            }
+        }
+
+        // Waits until the player hasn't been drawn ascending for settleMs in a row. Returns
+        // false if the game exits or that doesn't happen before the timeout.
+        bool WaitToSettle(int settleMs, int timeoutMs)
+        {
+            Clock::time_point giveUp = Clock::now() + std::chrono::milliseconds(timeoutMs);
+            Clock::time_point when;
+            while (WaitForAscending(std::min(giveUp, Clock::now() + std::chrono::milliseconds(settleMs)), when))
+            {
+            }
+            return Clock::now() < giveUp && IsRunning();
+        }
+
+        bool IsRunning()
+        {
+            return pid > 0 && waitpid(pid, NULL, WNOHANG) == 0;
+        }
+
+    private:
+        pid_t pid = -1;
+        int fd = -1;
+        AscendingScanner scanner;
+
+        bool WaitForExit(int timeoutMs)
+        {
+            Clock::time_point giveUp = Clock::now() + std::chrono::milliseconds(timeoutMs);
+            char data[4096];
+            while (Clock::now() < giveUp)
+            {
+                if (waitpid(pid, NULL, WNOHANG) == pid)
+                    return true;
+
+                // Its output has to keep being read, or it could block writing the last frame
+                struct pollfd pollFd = {};
+                pollFd.fd = fd;
+                pollFd.events = POLLIN;
+                if (poll(&pollFd, 1, GAME_SPEED) > 0 && read(fd, data, sizeof(data)) <= 0)
+                {
+                    waitpid(pid, NULL, 0);
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    struct LatencyStats
+    {
+        std::vector<double> samplesMs;
+        int missed = 0;
+    };
+
+    // Starts the game with args and times how long each of presses SPACE presses takes to show up
+    LatencyStats MeasureLatency(const std::string &binary, const std::vector<std::string> &args, int presses, Pcg32 &random)
+    {
+        LatencyStats stats;
+        TerminalGame game;
+        if (!game.Start(binary, args))
+        {
+            stats.missed = presses;
+            return stats;
+        }
+
+        for (int i = 0; i < presses; i++)
+        {
+            if (!game.WaitToSettle(LATENCY_SETTLE_MS, LATENCY_TIMEOUT_MS))
+            {
+                stats.missed += presses - i;
+                break;
+            }
+
+            std::this_thread::sleep_for(std::chrono::microseconds(random.Below(LATENCY_JITTER_US)));
+
+            Clock::time_point pressed = Clock::now();
+            Clock::time_point shown;
+            if (game.Press(' ') && game.WaitForAscending(pressed + std::chrono::milliseconds(LATENCY_TIMEOUT_MS), shown))
+                stats.samplesMs.push_back(std::chrono::duration<double, std::milli>(shown - pressed).count());
+            else
+                stats.missed++;
+        }
+        return stats;
+    }
+
+    void PrintLatency(const char *name, LatencyStats &stats)
+    {
+        std::vector<double> &samples = stats.samplesMs;
+        std::sort(samples.begin(), samples.end());
+
+        double total = 0;
+        for (double sample : samples)
+        {
+            total += sample;
+        }
+
+        auto percentile = [&](double p) { return samples.empty() ? 0 : samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))]; };
+        printf("%-36s %8.2f %8.2f %8.2f %8.2f %8.2f %8d\n", name, percentile(0.5), percentile(0.9), percentile(0.99),
+               samples.empty() ? 0 : samples.back(), samples.empty() ? 0 : total / samples.size(), stats.missed);
+        fflush(stdout);
+    }
+} // namespace RunButLikeActually
+
+void PrintUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [options] [-- <game options>]" << std::endl;
+    std::cerr << "  --binary <path>    the game to run, defaults to ./main" << std::endl;
+    std::cerr << "  --presses <n>      SPACE presses to time for each configuration" << std::endl;
+    std::cerr << "Without any game options, each input backend and renderer is timed in turn." << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace RunButLikeActually;
+
+    std::string binary = "./main";
+    int presses = LATENCY_PRESSES;
+    std::vector<std::string> gameArgs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--binary" && i + 1 < argc)
+        {
+            binary = argv[++i];
+        }
+        else if (arg == "--presses" && i + 1 < argc)
+        {
+            presses = std::max(1, atoi(argv[++i]));
+        }
+        else if (arg == "--")
+        {
+            gameArgs.assign(argv + i + 1, argv + argc);
+            break;
+        }
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Nothing to jump over means nothing can end the game between presses
+    char levelPath[] = "/tmp/latency-level-XXXXXX";
+    int levelFd = mkstemp(levelPath);
+    Level level;
+    level.heights.assign(LATENCY_LEVEL_COLUMNS, 0);
+    if (levelFd < 0 || close(levelFd) != 0 || !level.Save(levelPath))
+    {
+        std::cerr << "Couldn't write an empty level to " << levelPath << std::endl;
+        return 1;
+    }
+
+    struct Configuration
+    {
+        const char *name;
+        std::vector<std::string> args;
+    };
+
+    std::vector<Configuration> configurations;
+    if (gameArgs.empty())
+    {
+        configurations = {
+            {"diff renderer, ConsoleInput", {}},
+            {"diff renderer, kbhit polling", {"--legacy-input"}},
+            {"diff renderer on its own thread", {"--render-thread"}},
+            {"clear and reprint, ConsoleInput", {"--legacy-renderer"}},
+            {"clear and reprint, kbhit polling", {"--legacy-renderer", "--legacy-input"}},
+        };
+    }
+    else
+    {
+        configurations.push_back({"given options", gameArgs});
+    }
+
+    printf("presses: %d, terminal: %dx%d\n", presses, LATENCY_TERMINAL_ROWS, LATENCY_TERMINAL_COLS);
+    printf("%-36s %8s %8s %8s %8s %8s %8s\n", "configuration (ms)", "p50", "p90", "p99", "max", "mean", "missed");
+
+    Pcg32 random(RandomSeed());
+    for (Configuration &configuration : configurations)
+    {
+        std::vector<std::string> args = {"--level", levelPath, "--no-scores"};
+        args.insert(args.end(), configuration.args.begin(), configuration.args.end());
+
+        LatencyStats stats = MeasureLatency(binary, args, presses, random);
+        PrintLatency(configuration.name, stats);
+    }
+
+    unlink(levelPath);
+    return 0;
+}
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <random.h>
+#include <spsc_queue.h>
+#include <tagged_file.h>
+
+namespace RunButLikeActually
+{
+    const char LEVEL_MAGIC[4] = {'R', 'B', 'L', 'V'};
+    const uint8_t LEVEL_VERSION = 1;
+
+    // Columns generated at a time
+    const int LEVEL_CHUNK_COLUMNS = 256;
+
+    // Chunks the prefetch thread keeps ready, which at one column a tick is about ten seconds of play
+    const size_t LEVEL_PREFETCH_CHUNKS = 4;
+
+    // The height of the obstacle that spawns in each column, 0 where none does
+    struct LevelChunk
+    {
+        std::array<uint8_t, LEVEL_CHUNK_COLUMNS> heights = {};
+    };
+
+    // Tightens the gap obstacles are spawned with as the score rises. Every pointsPerStep points
+    // take a column off MIN_OBSTACLE_GAP, down to HARDEST_OBSTACLE_GAP. 0 keeps it where it is.
+    struct DifficultyCurve
+    {
+        int pointsPerStep = 0;
+    };
+
+    // A fixed run of columns to play instead of generated ones. On disk that's a small header
+    // followed by one byte per column, holding the obstacle height just like a LevelChunk.
+    class Level
+    {
+    public:
+        std::vector<uint8_t> heights;
+
+        // FNV-1a of the heights, which is never 0, so replays can tell if they're played on the
+        // level they were recorded on
+        uint64_t GetHash() const
+        {
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (uint8_t height : heights)
+            {
+                hash = (hash ^ height) * 0x100000001b3ull;
+            }
+            return hash ? hash : 1;
+        }
+
+        bool Save(const std::string &path) const
+        {
+            std::vector<uint8_t> data = StartTaggedFile(LEVEL_MAGIC, LEVEL_VERSION);
+            data.insert(data.end(), heights.begin(), heights.end());
+            return SaveTaggedFile(path, data);
+        }
+
+        // Returns false if the file can't be read or isn't a level
+        bool Load(const std::string &path)
+        {
+            std::vector<uint8_t> data;
+            if (!LoadTaggedFile(path, LEVEL_MAGIC, LEVEL_VERSION, data))
+                return false;
+
+            heights.assign(data.begin() + TAGGED_FILE_HEADER_SIZE, data.end());
+            return true;
+        }
+    };
+
+    // Where a game's obstacles come from, one column a tick. The columns of the level, if there
+    // is one, come first and the generator carries on from where it ends. Either way they're made
+    // a LevelChunk at a time, so Tick() only reads the next byte of the current chunk.
+    //
+    // Chunks are made inline when they run out unless StartPrefetch() has been called, in which
+    // case a thread keeps LEVEL_PREFETCH_CHUNKS of them ready. Both give the same columns.
+    template <typename Config>
+    class BasicLevelStream
+    {
+    public:
+        // Closer than this and back to back jumps can't clear every obstacle
+        static constexpr int HARDEST_OBSTACLE_GAP = std::min(Config::MIN_OBSTACLE_GAP, Config::PLAYER_JUMP_DISTANCE - 2);
+
+        static_assert(Config::MAX_OBSTACLE_HEIGHT <= UINT8_MAX, "Heights are stored as bytes");
+
+        // The level has to outlive the stream
+        BasicLevelStream(uint64_t seed, DifficultyCurve difficulty, const Level *level = nullptr)
+            : random(seed), difficulty(difficulty), level(level)
+        {
+        }
+
+        ~BasicLevelStream()
+        {
+            StopPrefetch();
+        }
+
+        BasicLevelStream(const BasicLevelStream &) = delete;
+        BasicLevelStream &operator=(const BasicLevelStream &) = delete;
+
+        // The height of the obstacle in the next column, or 0 if there isn't one
+        int NextColumn()
+        {
+            if (nextColumn == LEVEL_CHUNK_COLUMNS)
+            {
+                FetchChunk(chunk);
+                nextColumn = 0;
+            }
+            return chunk.heights[nextColumn++];
+        }
+
+        void StartPrefetch()
+        {
+            if (prefetch && prefetch->thread.joinable())
+                return;
+
+            if (!prefetch)
+                prefetch.reset(new Prefetch());
+
+            prefetch->isRunning = true;
+            prefetch->thread = std::thread([this]() { RunPrefetch(); });
+        }
+
+        // Chunks already made are still handed out before any more are made inline
+        void StopPrefetch()
+        {
+            if (!prefetch || !prefetch->thread.joinable())
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(prefetch->mutex);
+                prefetch->isRunning = false;
+            }
+            prefetch->wake.notify_all();
+            prefetch->thread.join();
+        }
+
+    private:
+        struct Prefetch
+        {
+            SpscQueue<LevelChunk, LEVEL_PREFETCH_CHUNKS> chunks;
+            std::thread thread;
+            std::mutex mutex;
+            std::condition_variable wake;
+            bool isRunning = false;
+            size_t pushedCount = 0;
+            size_t poppedCount = 0;
+
+            // Made by the thread but not queued yet, because the queue was full when it stopped
+            LevelChunk pending;
+            bool hasPending = false;
+        };
+
+        // Only touched by the prefetch thread while it runs
+        Pcg32 random;
+        DifficultyCurve difficulty;
+        const Level *level;
+        size_t levelColumn = 0;
+        int lastObstacleDist = Config::MAX_OBSTACLE_GAP + 1;
+        int obstacleCount = 0;
+
+        LevelChunk chunk;
+        int nextColumn = LEVEL_CHUNK_COLUMNS;
+        std::unique_ptr<Prefetch> prefetch;
+
+        void FetchChunk(LevelChunk &next)
+        {
+            if (prefetch)
+            {
+                // Only waits if the thread has somehow fallen a whole queue behind
+                std::unique_lock<std::mutex> lock(prefetch->mutex);
+                prefetch->wake.wait(lock, [this]() { return prefetch->poppedCount < prefetch->pushedCount || !prefetch->isRunning; });
+
+                if (prefetch->chunks.TryPop(next))
+                {
+                    prefetch->poppedCount++;
+                    lock.unlock();
+                    prefetch->wake.notify_all();
+                    return;
+                }
+
+                bool hasPending = prefetch->hasPending;
+                if (hasPending)
+                    next = prefetch->pending;
+                lock.unlock();
+
+                prefetch.reset();
+                if (hasPending)
+                    return;
+            }
+
+            MakeChunk(next);
+        }
+
+        void RunPrefetch()
+        {
+            Prefetch &state = *prefetch;
+            while (true)
+            {
+                if (!state.hasPending)
+                {
+                    MakeChunk(state.pending);
+                    state.hasPending = true;
+                }
+
+                std::unique_lock<std::mutex> lock(state.mutex);
+                if (state.chunks.TryPush(state.pending))
+                {
+                    state.hasPending = false;
+                    state.pushedCount++;
+                    lock.unlock();
+                    state.wake.notify_all();
+                    continue;
+                }
+
+                state.wake.wait(lock, [&]() { return state.pushedCount - state.poppedCount < LEVEL_PREFETCH_CHUNKS || !state.isRunning; });
+                if (!state.isRunning)
+                    return;
+            }
+        }
+
+        void MakeChunk(LevelChunk &next)
+        {
+            for (uint8_t &height : next.heights)
+            {
+                height = (uint8_t)MakeColumn();
+            }
+        }
+
+        int GetMinObstacleGap() const
+        {
+            // The player's score on reaching an obstacle is the number of obstacles before it
+            if (difficulty.pointsPerStep <= 0)
+                return Config::MIN_OBSTACLE_GAP;
+            return std::max(HARDEST_OBSTACLE_GAP, Config::MIN_OBSTACLE_GAP - obstacleCount / difficulty.pointsPerStep);
+        }
+
+        int MakeColumn()
+        {
+            int height = 0;
+            if (level && levelColumn < level->heights.size())
+            {
+                // Obstacles the game couldn't fit on the board or the player couldn't clear are left out
+                height = level->heights[levelColumn++];
+                if (lastObstacleDist <= HARDEST_OBSTACLE_GAP)
+                    height = 0;
+                else if (height > 0)
+                    height = std::clamp(height, Config::MIN_OBSTACLE_HEIGHT, Config::MAX_OBSTACLE_HEIGHT);
+            }
+            else if (lastObstacleDist > Config::MAX_OBSTACLE_GAP ||
+                     (lastObstacleDist > GetMinObstacleGap() && random.Range(0, 101) < Config::OBSTACLE_CREATION_CHANCE))
+            {
+                height = random.Range(Config::MIN_OBSTACLE_HEIGHT, Config::MAX_OBSTACLE_HEIGHT + 1);
+            }
+
+            if (height == 0)
+            {
+                lastObstacleDist++;
+                return 0;
+            }
+
+            lastObstacleDist = 0;
+            obstacleCount++;
+            return height;
+        }
+    };
+} // namespace RunButLikeActually
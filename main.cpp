@@ -1,375 +1,506 @@
-#define NOMINMAX
-#define DEBUG 0
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <ctime>
-#include <iostream>
-#include <vector>
-#include <array>
+#include <game.h>
+#include <headless.h>
+#include <batch.h>
+#include <server.h>
+#include <cmath>
 #include <sstream>
-#include <chrono>
-#include <thread>
-#include <rlutil.h>
-#include <atomic>
-#include <algorithm>
+#include <time.h>
 
-namespace RunButLikeActually
+#if DEBUG
+// Counts every allocation for the frameAllocations debug line. The array and nothrow forms
+// all end up in one of the two operator news here, and their deletes in the matching delete.
+void *operator new(size_t size)
 {
-    using std::array;
-    using std::atomic;
-    using std::cout;
-    using std::endl;
-    using std::string;
-    using std::stringstream;
-    using std::thread;
-    using std::vector;
-
-    // Game
-    const int GAME_SPEED = 10;
-    const int GAME_TILE_ROWS = 32;
-    const int GAME_TILE_COLS = 80;
-    const int GAME_PLAYER_POSITION = 20;
-
-    // Player jump settings. Height and distance should be odd and greater than 3.
-    const int PLAYER_JUMP_DISTANCE = 11;
-    const int PLAYER_JUMP_HEIGHT = 5;
-    const int PLAYER_JUMP_STEPS = PLAYER_JUMP_DISTANCE / 2; // Intentional integer division
-    const float PLAYER_JUMP_STEP_SIZE = (float)PLAYER_JUMP_HEIGHT / PLAYER_JUMP_STEPS;
-
-    // Obstacles
-    const int MIN_OBSTACLE_HEIGHT = 1;
-    const int MAX_OBSTACLE_HEIGHT = PLAYER_JUMP_HEIGHT - 1;
-    const int MIN_OBSTACLE_GAP = 11;
-    const int MAX_OBSTACLE_GAP = 80;
-    const int OBSTACLE_CREATION_CHANCE = 25;
-
-    // Symbols
-    const char EMPTY_SYMBOL = ' ';
-    const char WALL_SYMBOl = 'W';
-    const char PLAYER_SYMBOL_ASCENDING = '/';
-    const char PLAYER_SYMBOL_DESCENDING = '\\';
-    const char PLAYER_SYMBOL_FORWARD = '-';
-    const char PLAYER_SYMBOL_HEAD = '>';
-    const char PLAYER_SYMBOL_JUMP_TOP = '_';
-    const vector<char> OBSTACLE_SYMBOLS = {'#', '+', '?', '!'};
-    const string INSTRUCTIONS = "SPACE TO JUMP. ESC TO QUIT.";
-
-    // From: https://stackoverflow.com/a/52895729/11628429
-    void ClearConsole()
-    {
-#if defined _WIN32
-        system("cls");
-        //clrscr(); // including header file : conio.h
-#elif defined(__LINUX__) || defined(__gnu_linux__) || defined(__linux__)
-        system("clear");
-        //std::cout<< u8"\033[2J\033[1;1H"; //Using ANSI Escape Sequences
-#elif defined(__APPLE__)
-        system("clear");
-#endif
-    }
-
-    int RandRange(int min, int max)
-    {
-        return rand() % max + min;
-    }
-
-    string GetCenteredText(string text, int length)
-    {
-        length = std::max((int)text.length(), length);
-        return string((length - text.length()) / 2, ' ') + text;
-    }
+    RunButLikeActually::GetAllocationCounter().fetch_add(1, std::memory_order_relaxed);
+    if (void *data = malloc(size ? size : 1))
+        return data;
+    throw std::bad_alloc();
+}
 
-    class Game
-    {
-    public:
-        Game()
-        {
-            tiles[GAME_TILE_ROWS - 2][GAME_PLAYER_POSITION] = Tile::PlayerHead;
-            tiles[GAME_TILE_ROWS - 1].fill(Tile::Wall);
-
-            isGameRunning = false;
-            isJumping = false;
-        }
+void operator delete(void *data) noexcept
+{
+    free(data);
+}
 
-        void Run()
-        {
-            if (isGameRunning)
-                throw "We're already running.";
+void operator delete(void *data, size_t) noexcept
+{
+    free(data);
+}
 
-            isGameRunning = true;
-            srand((unsigned)time(0));
-            StartInputThread();
+// Anything over-aligned, like the queues with alignas(64), comes through these instead
+void *operator new(size_t size, std::align_val_t alignment)
+{
+    RunButLikeActually::GetAllocationCounter().fetch_add(1, std::memory_order_relaxed);
+#ifdef _WIN32
+    void *data = _aligned_malloc(size ? size : 1, (size_t)alignment);
+#else
+    void *data = nullptr;
+    if (posix_memalign(&data, std::max(sizeof(void *), (size_t)alignment), size ? size : 1) != 0)
+        data = nullptr;
+#endif
+    if (data)
+        return data;
+    throw std::bad_alloc();
+}
 
-            rlutil::hidecursor();
+void operator delete(void *data, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    free(data);
+#endif
+}
 
-            while (isGameRunning)
-            {
-                // The order of the operations in this loop is important.
-                // The actions taken are designed to be done in a specific order.
+void operator delete(void *data, size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(data, alignment);
+}
+#endif
 
-                PrintGameState();
+// Enough for a benchmark to run for about a minute before the generator takes over
+const long long LEVEL_WRITE_COLUMNS = 6000;
 
-                if (isPlayerColliding)
-                {
-                    isGameRunning = false;
-                    break;
-                }
+void PrintUsage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [options]" << std::endl;
+    std::cerr << "  --legacy-renderer        clear the console and reprint every frame" << std::endl;
+    std::cerr << "  --legacy-input           poll kbhit() instead of blocking on stdin" << std::endl;
+    std::cerr << "  --render-interval <ms>   minimum time between frames" << std::endl;
+    std::cerr << "  --render-thread          draw frames on their own thread" << std::endl;
+    std::cerr << "  --shimmer <ticks>        have each obstacle pick new glyphs this often" << std::endl;
+    std::cerr << "  --no-color               draw every tile in the terminal's default color, also set by NO_COLOR" << std::endl;
+    std::cerr << "  --profile <path>         show stage timings and write them to a .csv or Chrome trace .json on exit" << std::endl;
+    std::cerr << "  --spectate <port>        stream the game to anyone connecting on this TCP port" << std::endl;
+    std::cerr << "  --serve <port>           host a game for everyone who connects on this TCP port" << std::endl;
+    std::cerr << "  --scores <path>          keep the results of every game here, defaults to scores.rbls" << std::endl;
+    std::cerr << "  --no-scores              don't keep the results of this game" << std::endl;
+    std::cerr << "  --high-scores            list the best games kept in the scores and exit" << std::endl;
+    std::cerr << "  --seed <n>               seed for the obstacle generator" << std::endl;
+    std::cerr << "  --difficulty <points>    bring obstacles a column closer together every this many points" << std::endl;
+    std::cerr << "  --level <path>           play the obstacles in a level file before generating any" << std::endl;
+    std::cerr << "  --write-level <path>     save the first --level-columns columns the seed and difficulty generate and exit" << std::endl;
+    std::cerr << "  --level-columns <n>      how many columns --write-level saves" << std::endl;
+    std::cerr << "  --record <path>          save a replay of the game when it ends" << std::endl;
+    std::cerr << "  --replay <path>          watch a saved replay" << std::endl;
+    std::cerr << "  --replay-speed <x>       how many times faster than normal to show a replay" << std::endl;
+    std::cerr << "  --replay-headless <path> play a saved replay as fast as possible and report how it ended" << std::endl;
+    std::cerr << "  --headless <ticks>       simulate without a terminal and report ticks/sec" << std::endl;
+    std::cerr << "  --jump-distance <n>      how close an obstacle gets before the headless player jumps" << std::endl;
+    std::cerr << "  --batch <games>          play independent games on every core and report distributions" << std::endl;
+    std::cerr << "  --jump-distances <list>  comma separated jump distances to compare in a batch, auto for the autopilot" << std::endl;
+    std::cerr << "  --autopilot              have the search based autopilot play headless games" << std::endl;
+    std::cerr << "  --max-ticks <n>          stop batch games that survive this long" << std::endl;
+    std::cerr << "  --threads <n>            worker threads for a batch or server, defaults to one per core" << std::endl;
+    std::cerr << "  --multi-game             play batch games in lockstep on the vectorised MultiGame engine" << std::endl;
+}
+
+std::vector<int> ParseIntList(const std::string &text)
+{
+    std::vector<int> values;
+    std::stringstream ss(text);
+    std::string item;
 
-                UpdateScore();
-                UpdatePlayerPosition();
-                UpdateTilesAndCheckForCollisions();
-                UpdateObstacles();
+    while (std::getline(ss, item, ','))
+    {
+        if (item == "auto")
+            values.push_back(RunButLikeActually::BATCH_AUTOPILOT);
+        else if (!item.empty())
+            values.push_back(atoi(item.c_str()));
+    }
 
-                std::this_thread::sleep_for(std::chrono::milliseconds(GAME_SPEED));
-            }
+    return values;
+}
 
-            rlutil::showcursor();
+void PrintBatchResult(const RunButLikeActually::BatchOptions &options, const RunButLikeActually::BatchResult &result)
+{
+    printf("games: %lld, seed: %llu, max ticks: %lld, engine: %s\n", options.games, (unsigned long long)options.seed, options.maxTicks,
+           options.useMultiGame ? RunButLikeActually::SimdLanes::NAME : "Game");
+    printf("seconds: %.3f, ticks/sec: %.0f\n", result.seconds, result.seconds > 0 ? result.totalTicks / result.seconds : 0);
+    printf("%8s %8s %9s | %9s %9s %9s %9s | %9s %9s %9s %9s\n", "distance", "games", "survived",
+           "score p10", "p50", "p90", "mean", "ticks p10", "p50", "p90", "mean");
 
-            StopInputThread();
-        }
+    for (const auto &stats : result.GetPolicyStats(options))
+    {
+        std::string policy = stats.jumpDistance == RunButLikeActually::BATCH_AUTOPILOT ? "auto" : std::to_string(stats.jumpDistance);
+        printf("%8s %8lld %9lld | %9.0f %9.0f %9.0f %9.1f | %9.0f %9.0f %9.0f %9.1f\n", policy.c_str(), stats.games, stats.survivedGames,
+               stats.scores.p10, stats.scores.p50, stats.scores.p90, stats.scores.mean,
+               stats.ticks.p10, stats.ticks.p50, stats.ticks.p90, stats.ticks.mean);
+    }
+}
 
-    protected:
-        enum class Tile
-        {
-            Empty,
-            Wall,
-            Obstacle,
-            PlayerHead,
-            PlayerAscending,
-            PlayerDescending,
-            PlayerForward,
-            PlayerJumpTop
-        };
+void PrintHighScores(RunButLikeActually::ScoreLog &scores)
+{
+    printf("games: %llu\n", (unsigned long long)scores.GetRecordCount());
+    printf("%4s %8s %8s  %-16s  %s\n", "rank", "score", "ticks", "finished", "seed");
 
-        int score = 0;
-        int playerSymbolIndex = 0;
-        int lastObstacleDist = MAX_OBSTACLE_GAP + 1;
-        array<array<Tile, GAME_TILE_COLS>, GAME_TILE_ROWS> tiles = {};
+    std::vector<RunButLikeActually::ScoreRecord> best = scores.GetTopScores(RunButLikeActually::SCORE_LOG_TOP_COUNT);
+    for (size_t i = 0; i < best.size(); i++)
+    {
+        char finished[32] = "";
+        time_t endTime = (time_t)best[i].endTime;
+        if (const tm *local = localtime(&endTime))
+            strftime(finished, sizeof(finished), "%Y-%m-%d %H:%M", local);
 
-        float playerYPos = 0;
-        int prevStepCount = 0;
-        int jumpStepCount = 0;
-        int direction = 0;
+        printf("%4zu %8d %8lld  %-16s  %llu\n", i + 1, best[i].score, (long long)best[i].ticks, finished, (unsigned long long)best[i].seed);
+    }
+}
 
-        thread inputThread;
-        atomic<bool> isGameRunning;
-        atomic<bool> isJumping;
-        bool isPlayerColliding = false;
+int main(int argc, char *argv[])
+{
+    RunButLikeActually::GameOptions options;
+    long long headlessTicks = 0;
+    int jumpDistance = RunButLikeActually::SCRIPTED_JUMP_DISTANCE;
+    RunButLikeActually::BatchOptions batchOptions;
+    bool isBatch = false;
+    std::string profilePath;
+    std::string recordPath;
+    std::string replayPath;
+    bool isHeadlessReplay = false;
+    bool useAutopilot = false;
+    RunButLikeActually::Replay replay;
+    int spectatorPort = -1;
+    int serverPort = -1;
+    std::string scoresPath = RunButLikeActually::SCORE_LOG_DEFAULT_PATH;
+    bool showHighScores = false;
+    RunButLikeActually::Level level;
+    std::string levelPath;
+    std::string writeLevelPath;
+    long long levelColumns = LEVEL_WRITE_COLUMNS;
+
+    // https://no-color.org
+    const char *noColor = getenv("NO_COLOR");
+    options.useColor = !noColor || !*noColor;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
 
-        void StartInputThread()
+        if (arg == "--legacy-renderer")
         {
-            inputThread = thread([this]() {
-                while (isGameRunning)
-                {
-                    if (kbhit())
-                    {
-                        char key = rlutil::getkey();
-                        switch (key)
-                        {
-                        case rlutil::KEY_SPACE:
-                            isJumping = true;
-                            break;
-                        case rlutil::KEY_ESCAPE:
-                            isGameRunning = false;
-                            break;
-                        }
-                    }
-                }
-            });
+            options.useLegacyRenderer = true;
         }
-
-        void StopInputThread()
+        else if (arg == "--legacy-input")
         {
-            inputThread.join();
+            options.useLegacyInput = true;
         }
-
-        Tile GetTrailingPlayerTile()
+        else if (arg == "--render-thread")
         {
-            Tile tile;
-
-            if (prevStepCount == 0 && jumpStepCount == 0)
-            {
-                tile = Tile::PlayerForward;
-            }
-            else if (prevStepCount < PLAYER_JUMP_STEPS)
-            {
-                tile = Tile::PlayerAscending;
-            }
-            else if (prevStepCount == PLAYER_JUMP_STEPS)
-            {
-                tile = Tile::PlayerJumpTop;
-            }
-            else
-            {
-                tile = Tile::PlayerDescending;
-            }
-
-            return tile;
+            options.useRenderThread = true;
         }
-
-        void UpdateTilesAndCheckForCollisions()
+        else if (arg == "--no-color")
         {
-            // Move all obstacles one column to the left
-            for (int i = 0; i < GAME_TILE_ROWS - 1; i++)
-            {
-                for (int j = 0; j < GAME_TILE_COLS - 1; j++)
-                {
-                    Tile tileAhead = tiles[i][j + 1];
-
-                    if (tileAhead == Tile::PlayerHead)
-                    {
-                        tiles[i][j] = GetTrailingPlayerTile();
-                    }
-                    else
-                    {
-                        tiles[i][j] = tileAhead;
-                    }
-                }
-                tiles[i][GAME_TILE_COLS - 1] = Tile::Empty;
-            }
-
-            Tile destTile = tiles[GAME_TILE_ROWS - 2 - (int)playerYPos][GAME_PLAYER_POSITION];
-            tiles[GAME_TILE_ROWS - 2 - (int)playerYPos][GAME_PLAYER_POSITION] = Tile::PlayerHead;
-            isPlayerColliding = destTile == Tile::Obstacle;
+            options.useColor = false;
         }
-
-        void UpdatePlayerPosition()
+        else if (arg == "--profile" && i + 1 < argc)
         {
-            prevStepCount = jumpStepCount;
-
-            if (!isJumping)
-                return;
-
-            direction = jumpStepCount < PLAYER_JUMP_STEPS ? 1 : -1;
-            playerYPos += PLAYER_JUMP_STEP_SIZE * direction;
-
-            jumpStepCount++;
-
-            if (jumpStepCount == PLAYER_JUMP_DISTANCE - 1)
+            options.isProfiling = true;
+            profilePath = argv[++i];
+        }
+        else if (arg == "--record" && i + 1 < argc)
+        {
+            options.isRecording = true;
+            recordPath = argv[++i];
+        }
+        else if ((arg == "--replay" || arg == "--replay-headless") && i + 1 < argc)
+        {
+            isHeadlessReplay = arg == "--replay-headless";
+            replayPath = argv[++i];
+        }
+        else if (arg == "--replay-speed" && i + 1 < argc)
+        {
+            const char *text = argv[++i];
+            char *end;
+            options.playbackSpeed = strtod(text, &end);
+            if (end == text || *end || !(options.playbackSpeed > 0) || !std::isfinite(options.playbackSpeed))
             {
-                jumpStepCount = 0;
-                isJumping = false;
+                std::cerr << "The replay speed has to be a finite number above 0: " << text << std::endl;
+                PrintUsage(argv[0]);
+                return 1;
             }
         }
-
-        void UpdateScore()
+        else if (arg == "--render-interval" && i + 1 < argc)
         {
-            // The player gets 1 point each time they jump over an obstacle
-            Tile tileBeneathPlayer = tiles[GAME_TILE_ROWS - 2][GAME_PLAYER_POSITION];
-            score += tileBeneathPlayer == Tile::Obstacle;
+            options.renderInterval = std::max(0, atoi(argv[++i]));
         }
-
-        bool ObstacleSpawnAvailable()
+        else if (arg == "--shimmer" && i + 1 < argc)
+        {
+            options.shimmerInterval = std::max(0, atoi(argv[++i]));
+        }
+        else if (arg == "--spectate" && i + 1 < argc)
+        {
+            spectatorPort = atoi(argv[++i]);
+        }
+        else if (arg == "--serve" && i + 1 < argc)
+        {
+            serverPort = atoi(argv[++i]);
+        }
+        else if (arg == "--scores" && i + 1 < argc)
+        {
+            scoresPath = argv[++i];
+        }
+        else if (arg == "--no-scores")
+        {
+            scoresPath.clear();
+        }
+        else if (arg == "--high-scores")
+        {
+            showHighScores = true;
+        }
+        else if (arg == "--difficulty" && i + 1 < argc)
+        {
+            options.difficulty.pointsPerStep = std::max(0, atoi(argv[++i]));
+        }
+        else if (arg == "--level" && i + 1 < argc)
+        {
+            levelPath = argv[++i];
+        }
+        else if (arg == "--write-level" && i + 1 < argc)
+        {
+            writeLevelPath = argv[++i];
+        }
+        else if (arg == "--level-columns" && i + 1 < argc)
+        {
+            levelColumns = std::max(0LL, atoll(argv[++i]));
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (arg == "--headless" && i + 1 < argc)
+        {
+            headlessTicks = std::max(0LL, atoll(argv[++i]));
+        }
+        else if (arg == "--autopilot")
+        {
+            useAutopilot = true;
+        }
+        else if (arg == "--jump-distance" && i + 1 < argc)
+        {
+            jumpDistance = atoi(argv[++i]);
+        }
+        else if (arg == "--batch" && i + 1 < argc)
+        {
+            isBatch = true;
+            batchOptions.games = std::max(1LL, atoll(argv[++i]));
+        }
+        else if (arg == "--jump-distances" && i + 1 < argc)
+        {
+            batchOptions.jumpDistances = ParseIntList(argv[++i]);
+        }
+        else if (arg == "--max-ticks" && i + 1 < argc)
+        {
+            batchOptions.maxTicks = std::max(1LL, atoll(argv[++i]));
+        }
+        else if (arg == "--multi-game")
+        {
+            batchOptions.useMultiGame = true;
+        }
+        else if (arg == "--threads" && i + 1 < argc)
         {
-            if (lastObstacleDist > MAX_OBSTACLE_GAP)
-                return true;
-            return lastObstacleDist > MIN_OBSTACLE_GAP && RandRange(0, 101) < OBSTACLE_CREATION_CHANCE;
+            batchOptions.threads = std::max(0, atoi(argv[++i]));
         }
+        else
+        {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
 
-        void UpdateObstacles()
+    RunButLikeActually::ScoreLog scores;
+    if (showHighScores)
+    {
+        if (scoresPath.empty() || !scores.OpenForReading(scoresPath))
         {
-            if (ObstacleSpawnAvailable())
-            {
-                int height = RandRange(MIN_OBSTACLE_HEIGHT, MAX_OBSTACLE_HEIGHT + 1);
+            std::cerr << "Couldn't read the scores in " << scoresPath << std::endl;
+            return 1;
+        }
 
-                for (int i = GAME_TILE_ROWS - 1; i >= GAME_TILE_ROWS - 1 - height; i--)
-                {
-                    tiles[i][GAME_TILE_COLS - 1] = Tile::Obstacle;
-                }
+        PrintHighScores(scores);
+        return 0;
+    }
 
-                lastObstacleDist = 0;
-            }
-            else
-            {
-                lastObstacleDist++;
-            }
+    if (!levelPath.empty())
+    {
+        if (!level.Load(levelPath))
+        {
+            std::cerr << "Couldn't read a level from " << levelPath << std::endl;
+            return 1;
         }
+        options.level = &level;
+    }
 
-        char GetPlayerSymbol()
+    if (!writeLevelPath.empty())
+    {
+        RunButLikeActually::Game::LevelType stream(options.seed, options.difficulty, options.level);
+        RunButLikeActually::Level generated;
+        for (long long i = 0; i < levelColumns; i++)
         {
-            return PLAYER_SYMBOL_HEAD;
+            generated.heights.push_back((uint8_t)stream.NextColumn());
         }
 
-        char GetRandomObstacleSymbol()
+        if (!generated.Save(writeLevelPath))
         {
-            return OBSTACLE_SYMBOLS[RandRange(0, OBSTACLE_SYMBOLS.size())];
+            std::cerr << "Couldn't write the level to " << writeLevelPath << std::endl;
+            return 1;
         }
+        return 0;
+    }
 
-        string GetCenteredScore()
+    if (!replayPath.empty())
+    {
+        if (!replay.Load(replayPath))
         {
-            return GetCenteredText("SCORE: " + std::to_string(score), GAME_TILE_COLS);
+            std::cerr << "Couldn't read a replay from " << replayPath << std::endl;
+            return 1;
         }
 
-        string GetCenteredInstructions()
+        // A different level would play a different game, so it's refused instead
+        uint64_t levelHash = options.level ? level.GetHash() : 0;
+        if (levelHash != replay.levelHash)
         {
-            return GetCenteredText(INSTRUCTIONS, GAME_TILE_COLS);
+            if (!replay.levelHash)
+                std::cerr << "This replay wasn't played on a level, so it can't be played with --level" << std::endl;
+            else if (!levelHash)
+                std::cerr << "This replay was played on a level, so pass the same one with --level" << std::endl;
+            else
+                std::cerr << "This replay was played on a different level" << std::endl;
+            return 1;
         }
 
-        string GetTileString()
+        options.seed = replay.seed;
+        options.difficulty.pointsPerStep = replay.pointsPerStep;
+        options.playback = &replay;
+    }
+
+    if (isHeadlessReplay)
+    {
+        RunButLikeActually::ReplayStats stats = RunButLikeActually::RunReplay(replay, options);
+        printf("seed: %llu\n", (unsigned long long)replay.seed);
+        printf("ticks: %lld of %lld\n", stats.ticks, replay.endTick);
+        printf("score: %d\n", stats.score);
+        printf("crashed: %s\n", stats.isColliding ? "yes" : "no");
+        printf("seconds: %.6f\n", stats.seconds);
+        printf("ticks/sec: %.0f\n", stats.seconds > 0 ? stats.ticks / stats.seconds : 0);
+        return 0;
+    }
+
+    if (isBatch)
+    {
+        if (batchOptions.jumpDistances.empty())
+            batchOptions.jumpDistances.push_back(jumpDistance);
+
+        batchOptions.seed = options.seed;
+        batchOptions.difficulty = options.difficulty;
+        batchOptions.level = options.level;
+        if (batchOptions.useMultiGame && !batchOptions.UsesFixedGenerator())
         {
-            stringstream ss;
+            std::cerr << "--multi-game can't be used with --difficulty or --level" << std::endl;
+            PrintUsage(argv[0]);
+            return 1;
+        }
 
-            for (auto row : tiles)
-            {
-                for (auto tile : row)
-                {
-                    switch (tile)
-                    {
-                    case Tile::Empty:
-                        ss << EMPTY_SYMBOL;
-                        break;
-                    case Tile::Wall:
-                        ss << WALL_SYMBOl;
-                        break;
-                    case Tile::PlayerHead:
-                        ss << PLAYER_SYMBOL_HEAD;
-                        break;
-                    case Tile::PlayerAscending:
-                        ss << PLAYER_SYMBOL_ASCENDING;
-                        break;
-                    case Tile::PlayerDescending:
-                        ss << PLAYER_SYMBOL_DESCENDING;
-                        break;
-                    case Tile::PlayerForward:
-                        ss << PLAYER_SYMBOL_FORWARD;
-                        break;
-                    case Tile::PlayerJumpTop:
-                        ss << PLAYER_SYMBOL_JUMP_TOP;
-                        break;
-                    case Tile::Obstacle:
-                        ss << GetRandomObstacleSymbol();
-                        break;
-                    }
-                }
-                ss << endl;
-            }
+        PrintBatchResult(batchOptions, RunButLikeActually::RunBatch(batchOptions));
+        return 0;
+    }
 
-#if DEBUG
-            ss << "score: " << score << endl;
-            ss << "playerYPos: " << playerYPos << endl;
-            ss << "jumpStepCount: " << jumpStepCount << endl;
-            ss << "prevStepCount: " << prevStepCount << endl;
-            ss << "direction: " << direction << endl;
-            ss << "isPlayerColliding: " << isPlayerColliding << endl;
-#endif
+    if (headlessTicks > 0)
+    {
+        RunButLikeActually::ScriptedPolicy policy;
+        policy.jumpDistance = jumpDistance;
+        RunButLikeActually::Autopilot autopilot;
+
+        RunButLikeActually::HeadlessStats stats = useAutopilot ? RunButLikeActually::RunHeadless(headlessTicks, options, autopilot)
+                                                               : RunButLikeActually::RunHeadless(headlessTicks, options, policy);
+        printf("seed: %llu\n", (unsigned long long)options.seed);
+        if (useAutopilot)
+        {
+            long long lookups = autopilot.GetCacheHits() + autopilot.GetCacheMisses();
+            printf("autopilot cache hit rate: %.1f%%\n", lookups > 0 ? 100.0 * autopilot.GetCacheHits() / lookups : 0);
+        }
+        printf("ticks: %lld\n", stats.ticks);
+        printf("games: %lld\n", stats.games);
+        printf("mean score: %.2f\n", (double)stats.totalScore / stats.games);
+        printf("best score: %d\n", stats.bestScore);
+        printf("seconds: %.3f\n", stats.seconds);
+        printf("ticks/sec: %.0f\n", stats.TicksPerSecond());
+        return 0;
+    }
 
-            return ss.str();
+    if (serverPort >= 0)
+    {
+        RunButLikeActually::GameServerOptions serverOptions;
+        serverOptions.port = serverPort;
+        serverOptions.threads = batchOptions.threads;
+        serverOptions.seed = options.seed;
+        if (!scoresPath.empty() && scores.Open(scoresPath))
+            serverOptions.scores = &scores;
+        else if (!scoresPath.empty())
+            std::cerr << "Couldn't open the scores in " << scoresPath << ", so games won't be kept" << std::endl;
+
+        RunButLikeActually::GameServer server(serverOptions);
+        if (!server.Start())
+        {
+            std::cerr << "Couldn't listen for players on port " << serverPort << std::endl;
+            return 1;
         }
 
-        void PrintGameState()
+        printf("serving on port %d with %d threads\n", serverPort, server.GetThreadCount());
+        fflush(stdout);
+        server.Run([](const RunButLikeActually::GameServerStats &stats) {
+            printf("sessions: %zu, tick batches: %lld, update ms: %.3f mean %.3f max, dropped ticks: %lld\n", stats.sessions,
+                   stats.tickBatches, stats.meanUpdateMs, stats.maxUpdateMs, stats.droppedTicks);
+            fflush(stdout);
+        });
+        return 0;
+    }
+
+    RunButLikeActually::SpectatorServer spectators;
+    if (spectatorPort >= 0)
+    {
+        if (!spectators.Start(spectatorPort))
         {
-            ClearConsole();
-            cout << GetCenteredScore() << endl;
-            cout << GetTileString();
-            cout << GetCenteredInstructions() << endl;
+            std::cerr << "Couldn't listen for spectators on port " << spectatorPort << std::endl;
+            return 1;
         }
-    };
-} // namespace RunButLikeActually
+        options.spectators = &spectators;
+    }
 
-int main()
-{
-    RunButLikeActually::Game game;
+    // Frames are written straight to the console, so iostreams don't need to keep in step with stdio
+    std::ios::sync_with_stdio(false);
+
+    RunButLikeActually::Game game(options);
     game.Run();
+
+    // Replays aren't new games, so they aren't kept. The log is only opened once the game is
+    // over, so another game can keep its score in the meantime.
+    bool isKeepingScore = !scoresPath.empty() && !options.playback;
+    if (isKeepingScore && scores.Open(scoresPath))
+    {
+        scores.Append(game.GetScoreRecord());
+        scores.Flush();
+
+        std::vector<RunButLikeActually::ScoreRecord> best = scores.GetTopScores(1);
+        printf("score: %d, best: %d over %llu games\n", game.GetScore(), best.empty() ? game.GetScore() : best[0].score,
+               (unsigned long long)scores.GetRecordCount());
+        scores.Close();
+    }
+    else if (isKeepingScore)
+    {
+        std::cerr << "Couldn't open the scores in " << scoresPath << ", so this game wasn't kept" << std::endl;
+    }
+
+    if (!profilePath.empty() && !game.GetProfiler().Write(profilePath))
+    {
+        std::cerr << "Couldn't write the profile to " << profilePath << std::endl;
+        return 1;
+    }
+
+    if (!recordPath.empty() && !game.GetRecording().Save(recordPath))
+    {
+        std::cerr << "Couldn't write the replay to " << recordPath << std::endl;
+        return 1;
+    }
     return 0;
-}
\ No newline at end of file
+}
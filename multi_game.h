@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <string.h>
+#include <vector>
+#include <game.h>
+#include <random.h>
+#include <simd.h>
+
+namespace RunButLikeActually
+{
+    // Plays many headless games in lockstep with every piece of per game state stored in its own
+    // array, so the player and collision updates of a tick run over all games as vector loops.
+    // Only obstacle spawning, which needs each game's random generator, is done one game at a time.
+    //
+    // Every game plays with ScriptedPolicy and the given jump distance, and ends up with the same
+    // score and tick count as a BasicGame with the same config and seed would.
+    template <typename Config = GameConfig>
+    class BasicMultiGame
+    {
+    public:
+        typedef BasicGame<Config> GameType;
+
+        BasicMultiGame(const vector<uint64_t> &seeds, int jumpDistance, long long maxTicks)
+            : games((int)seeds.size()),
+              lanes((games + SimdLanes::WIDTH - 1) / SimdLanes::WIDTH * SimdLanes::WIDTH),
+              jumpDistance(jumpDistance),
+              maxTicks((int32_t)std::min<long long>(maxTicks, INT32_MAX)),
+              alive(lanes, 0), jumping(lanes, 0), jumpStep(lanes, 0), score(lanes, 0), ticks(lanes, 0),
+              lastObstacleDist(lanes, GameType::MAX_OBSTACLE_GAP + 1),
+              heights((size_t)lanes * GameType::TILE_COLS, 0)
+        {
+            // With obstacles at least MIN_OBSTACLE_GAP apart, the next obstacle is jumpDistance
+            // away exactly when that one column has an obstacle in it.
+            if (!IsSupportedJumpDistance(jumpDistance))
+                throw "Unsupported jump distance.";
+
+            random.reserve(games);
+            for (int i = 0; i < games; i++)
+            {
+                random.emplace_back(seeds[i]);
+                alive[i] = -1;
+            }
+
+            for (int step = 1; step < GameType::PLAYER_JUMP_DISTANCE - 1; step++)
+            {
+                heightSteps[step - 1] = GameType::GetJumpHeight(step) - GameType::GetJumpHeight(step - 1);
+            }
+        }
+
+        static bool IsSupportedJumpDistance(int jumpDistance)
+        {
+            return jumpDistance > 0 && jumpDistance <= GameType::MIN_OBSTACLE_GAP + 1 && GameType::PLAYER_POSITION + jumpDistance < GameType::TILE_COLS;
+        }
+
+        // Advances every game that is still running by one tick
+        void Step()
+        {
+            UpdateScoreAndPlayers();
+
+            headColumn = headColumn == GameType::TILE_COLS - 1 ? 0 : headColumn + 1;
+            memset(Column(GameType::TILE_COLS - 1), 0, sizeof(int32_t) * lanes);
+
+            UpdateCollisions();
+            UpdateObstacles();
+        }
+
+        // Steps until every game has crashed or reached maxTicks
+        void Run()
+        {
+            while (GetAliveCount() > 0)
+            {
+                Step();
+            }
+        }
+
+        int GetAliveCount() const
+        {
+            int count = 0;
+            for (int i = 0; i < games; i++)
+            {
+                count += alive[i] != 0;
+            }
+            return count;
+        }
+
+        int GetScore(int game) const
+        {
+            return score[game];
+        }
+
+        long long GetTicks(int game) const
+        {
+            return ticks[game];
+        }
+
+    private:
+        int games;
+        int lanes;
+        int jumpDistance;
+        int32_t maxTicks;
+
+        // Masks are all ones for true and zero for false
+        vector<int32_t> alive;
+        vector<int32_t> jumping;
+        vector<int32_t> jumpStep;
+        vector<int32_t> score;
+        vector<int32_t> ticks;
+        vector<int32_t> lastObstacleDist;
+        vector<Pcg32> random;
+
+        // Obstacle height in each column of each game. Columns form a ring so scrolling only moves
+        // headColumn, and hold the value for every game next to each other.
+        vector<int32_t> heights;
+        int headColumn = 0;
+
+        // How much the player's height changes going into each step of a jump
+        std::array<int32_t, GameType::PLAYER_JUMP_DISTANCE - 2> heightSteps = {};
+
+        int32_t *Column(int col)
+        {
+            int index = headColumn + col;
+            index = index >= GameType::TILE_COLS ? index - GameType::TILE_COLS : index;
+            return &heights[(size_t)index * lanes];
+        }
+
+        // The policy, UpdateScore() and UpdatePlayerPosition()
+        void UpdateScoreAndPlayers()
+        {
+            typedef SimdLanes S;
+            const S::Vector zero = S::Set(0);
+            const S::Vector lastStep = S::Set(GameType::PLAYER_JUMP_DISTANCE - 1);
+            const int32_t *ahead = Column(GameType::PLAYER_POSITION + jumpDistance);
+            const int32_t *below = Column(GameType::PLAYER_POSITION);
+
+            for (int i = 0; i < lanes; i += S::WIDTH)
+            {
+                S::Vector isAlive = S::Load(&alive[i]);
+                S::Vector isJumping = S::Load(&jumping[i]);
+                S::Vector step = S::Load(&jumpStep[i]);
+
+                isJumping = S::Or(isJumping, S::Greater(S::Load(ahead + i), zero));
+
+                S::Vector isScoring = S::And(S::Greater(S::Load(below + i), zero), isAlive);
+                S::Store(&score[i], S::Sub(S::Load(&score[i]), isScoring));
+
+                step = S::Sub(step, isJumping);
+                S::Vector hasLanded = S::Equal(step, lastStep);
+                S::Store(&jumpStep[i], S::AndNot(step, hasLanded));
+                S::Store(&jumping[i], S::AndNot(isJumping, hasLanded));
+            }
+        }
+
+        // The collision check from UpdateTilesAndCheckForCollisions()
+        void UpdateCollisions()
+        {
+            typedef SimdLanes S;
+            const S::Vector maxTickCount = S::Set(maxTicks);
+            const int32_t *current = Column(GameType::PLAYER_POSITION);
+
+            for (int i = 0; i < lanes; i += S::WIDTH)
+            {
+                S::Vector isAlive = S::Load(&alive[i]);
+                S::Vector step = S::Load(&jumpStep[i]);
+
+                S::Vector height = S::Set(0);
+                for (int j = 0; j < (int)heightSteps.size(); j++)
+                {
+                    height = S::Add(height, S::And(S::Greater(step, S::Set(j)), S::Set(heightSteps[j])));
+                }
+
+                S::Vector tickCount = S::Sub(S::Load(&ticks[i]), isAlive);
+                S::Store(&ticks[i], tickCount);
+
+                S::Vector isColliding = S::Greater(S::Load(current + i), height);
+                isAlive = S::AndNot(isAlive, isColliding);
+                S::Store(&alive[i], S::And(isAlive, S::Greater(maxTickCount, tickCount)));
+            }
+        }
+
+        // UpdateObstacles() for each game that is still running
+        void UpdateObstacles()
+        {
+            int32_t *column = Column(GameType::TILE_COLS - 1);
+
+            for (int i = 0; i < games; i++)
+            {
+                if (!alive[i])
+                    continue;
+
+                bool canSpawn = lastObstacleDist[i] > GameType::MAX_OBSTACLE_GAP ||
+                                (lastObstacleDist[i] > GameType::MIN_OBSTACLE_GAP && random[i].Range(0, 101) < GameType::OBSTACLE_CREATION_CHANCE);
+
+                if (canSpawn)
+                {
+                    column[i] = random[i].Range(GameType::MIN_OBSTACLE_HEIGHT, GameType::MAX_OBSTACLE_HEIGHT + 1);
+                    lastObstacleDist[i] = 0;
+                }
+                else
+                {
+                    lastObstacleDist[i]++;
+                }
+            }
+        }
+    };
+
+    typedef BasicMultiGame<> MultiGame;
+} // namespace RunButLikeActually
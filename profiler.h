@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace RunButLikeActually
+{
+    // Samples kept for the dump written on exit. Older ones are overwritten once it's full.
+    const size_t PROFILER_CAPACITY = 1 << 18;
+
+    // Recent samples of each stage the overlay works its percentiles out from
+    const size_t PROFILER_WINDOW = 256;
+
+    enum class ProfileStage : uint8_t
+    {
+        Update,
+        Collision,
+        ObstacleSpawn,
+        FrameBuild,
+        Output,
+        InputLatency,
+        Count
+    };
+
+    const char *const PROFILE_STAGE_NAMES[] = {"update", "collision", "obstacle spawn", "frame build", "output", "input latency"};
+    static_assert(sizeof(PROFILE_STAGE_NAMES) / sizeof(PROFILE_STAGE_NAMES[0]) == (size_t)ProfileStage::Count, "Every stage needs a name");
+
+    struct ProfileSample
+    {
+        long long tick;
+        ProfileStage stage;
+
+        // Nanoseconds since the profiler was created
+        int64_t start;
+        int64_t duration;
+    };
+
+    struct ProfileSummary
+    {
+        double p50 = 0;
+        double p99 = 0;
+        size_t count = 0;
+    };
+
+    // Records how long each stage of a tick takes. While it's disabled nothing is timed and the
+    // only cost is checking IsEnabled(). The buffers are allocated the first time it's enabled.
+    // Only meant to be used from one thread.
+    class Profiler
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        bool IsEnabled() const
+        {
+            return isEnabled;
+        }
+
+        void SetEnabled(bool enabled)
+        {
+            if (enabled && samples.empty())
+                samples.resize(PROFILER_CAPACITY);
+            isEnabled = enabled;
+        }
+
+        void Record(ProfileStage stage, long long tick, Clock::time_point start, Clock::time_point end)
+        {
+            ProfileSample &sample = samples[nextSample];
+            sample.tick = tick;
+            sample.stage = stage;
+            sample.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch).count();
+            sample.duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+            nextSample = nextSample + 1 == samples.size() ? 0 : nextSample + 1;
+            sampleCount = std::min(sampleCount + 1, samples.size());
+
+            StageWindow &window = windows[(size_t)stage];
+            window.durations[window.next] = sample.duration;
+            window.next = (window.next + 1) % PROFILER_WINDOW;
+            window.count = std::min(window.count + 1, PROFILER_WINDOW);
+        }
+
+        // Percentiles over the last PROFILER_WINDOW samples of a stage, in microseconds
+        ProfileSummary GetSummary(ProfileStage stage)
+        {
+            const StageWindow &window = windows[(size_t)stage];
+            ProfileSummary summary;
+            summary.count = window.count;
+            if (window.count == 0)
+                return summary;
+
+            std::copy(window.durations.begin(), window.durations.begin() + window.count, scratch.begin());
+            auto end = scratch.begin() + window.count;
+
+            auto p50 = scratch.begin() + (window.count - 1) / 2;
+            std::nth_element(scratch.begin(), p50, end);
+            summary.p50 = *p50 / 1000.0;
+
+            auto p99 = scratch.begin() + (window.count - 1) * 99 / 100;
+            std::nth_element(scratch.begin(), p99, end);
+            summary.p99 = *p99 / 1000.0;
+            return summary;
+        }
+
+        // Writes every kept sample, oldest first. Paths ending in .json get the Chrome trace
+        // event format that chrome://tracing and Perfetto open, anything else gets CSV.
+        bool Write(const std::string &path) const
+        {
+            FILE *file = fopen(path.c_str(), "w");
+            if (!file)
+                return false;
+
+            bool isTrace = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+            if (isTrace)
+                fputs("{\"traceEvents\":[\n", file);
+            else
+                fputs("tick,stage,start_us,duration_us\n", file);
+
+            size_t first = sampleCount < samples.size() ? 0 : nextSample;
+            for (size_t i = 0; i < sampleCount; i++)
+            {
+                const ProfileSample &sample = samples[(first + i) % samples.size()];
+                const char *name = PROFILE_STAGE_NAMES[(size_t)sample.stage];
+
+                if (isTrace)
+                {
+                    fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"tick\":%lld}}",
+                            i == 0 ? "" : ",\n", name, sample.start / 1000.0, sample.duration / 1000.0, sample.tick);
+                }
+                else
+                {
+                    fprintf(file, "%lld,%s,%.3f,%.3f\n", sample.tick, name, sample.start / 1000.0, sample.duration / 1000.0);
+                }
+            }
+
+            if (isTrace)
+                fputs("\n]}\n", file);
+
+            return fclose(file) == 0;
+        }
+
+    private:
+        struct StageWindow
+        {
+            std::array<int64_t, PROFILER_WINDOW> durations = {};
+            size_t next = 0;
+            size_t count = 0;
+        };
+
+        bool isEnabled = false;
+        Clock::time_point epoch = Clock::now();
+
+        std::vector<ProfileSample> samples;
+        size_t nextSample = 0;
+        size_t sampleCount = 0;
+
+        std::array<StageWindow, (size_t)ProfileStage::Count> windows;
+        std::array<int64_t, PROFILER_WINDOW> scratch = {};
+    };
+
+    // Times the enclosing block as one stage, if the profiler is enabled
+    class ProfileScope
+    {
+    public:
+        ProfileScope(Profiler &profiler, ProfileStage stage, long long tick)
+            : profiler(profiler), stage(stage), tick(tick)
+        {
+            if (profiler.IsEnabled())
+                start = Profiler::Clock::now();
+        }
+
+        ~ProfileScope()
+        {
+            if (profiler.IsEnabled() && start != Profiler::Clock::time_point())
+                profiler.Record(stage, tick, start, Profiler::Clock::now());
+        }
+
+        ProfileScope(const ProfileScope &) = delete;
+        ProfileScope &operator=(const ProfileScope &) = delete;
+
+    private:
+        Profiler &profiler;
+        ProfileStage stage;
+        long long tick;
+        Profiler::Clock::time_point start;
+    };
+} // namespace RunButLikeActually
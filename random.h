@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <random>
+#include <stdint.h>
+
+namespace RunButLikeActually
+{
+    // PCG32 (https://www.pcg-random.org). Small, fast and fully determined by its seed, so two
+    // games with the same seed play out the same way.
+    class Pcg32
+    {
+    public:
+        explicit Pcg32(uint64_t seed = 0, uint64_t stream = 0)
+        {
+            Seed(seed, stream);
+        }
+
+        void Seed(uint64_t seed, uint64_t stream = 0)
+        {
+            state = 0;
+            increment = (stream << 1u) | 1u;
+            Next();
+            state += seed;
+            Next();
+        }
+
+        uint32_t Next()
+        {
+            uint64_t old = state;
+            state = old * 6364136223846793005ULL + increment;
+            uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+            uint32_t rotation = (uint32_t)(old >> 59u);
+            return (xorshifted >> rotation) | (xorshifted << ((0u - rotation) & 31));
+        }
+
+        // Returns a number in [0, bound) without the bias of Next() % bound.
+        // From: https://arxiv.org/abs/1805.10941
+        uint32_t Below(uint32_t bound)
+        {
+            uint64_t product = (uint64_t)Next() * bound;
+            uint32_t low = (uint32_t)product;
+
+            if (low < bound)
+            {
+                uint32_t threshold = (0u - bound) % bound;
+                while (low < threshold)
+                {
+                    product = (uint64_t)Next() * bound;
+                    low = (uint32_t)product;
+                }
+            }
+
+            return (uint32_t)(product >> 32);
+        }
+
+        // Returns a number in [min, max)
+        int Range(int min, int max)
+        {
+            return min + (int)Below((uint32_t)(max - min));
+        }
+
+    private:
+        uint64_t state;
+        uint64_t increment;
+    };
+
+    inline uint64_t RandomSeed()
+    {
+        std::random_device device;
+        uint64_t seed = ((uint64_t)device() << 32) | device();
+        return seed ^ (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+} // namespace RunButLikeActually
@@ -0,0 +1,506 @@
+#pragma once
+
+#include <algorithm>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+namespace RunButLikeActually
+{
+    using std::string;
+    using std::vector;
+
+    const size_t CONSOLE_OUTPUT_CAPACITY = 1 << 16;
+
+    // Colors are rlutil's color codes, 0 to 15, or this for whatever the terminal uses by default
+    const uint8_t DEFAULT_COLOR = 0xff;
+
+    // Windows consoles only understand ANSI cursor moves once virtual terminal processing is on.
+    inline void EnableAnsiEscapes()
+    {
+#ifdef _WIN32
+        HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        if (GetConsoleMode(handle, &mode))
+            SetConsoleMode(handle, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+#endif
+    }
+
+    // Writes the whole buffer straight to the console, bypassing the stdio and iostream buffers.
+    inline void WriteToConsole(const char *data, size_t length)
+    {
+#ifdef _WIN32
+        HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+        while (length > 0)
+        {
+            DWORD written = 0;
+            if (!WriteFile(handle, data, (DWORD)length, &written, NULL))
+                return;
+            data += written;
+            length -= written;
+        }
+#else
+        while (length > 0)
+        {
+            ssize_t written = write(STDOUT_FILENO, data, length);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+            data += written;
+            length -= (size_t)written;
+        }
+#endif
+    }
+
+    // Synchronized output (DEC private mode 2026) has the terminal hold off showing a frame until
+    // all of it has arrived. Terminals that don't know the mode ignore it, but dumb terminals and
+    // the Linux console are left alone.
+    inline bool IsSynchronizedOutputSupported()
+    {
+        const char *term = getenv("TERM");
+        return !term || (strcmp(term, "dumb") != 0 && strcmp(term, "linux") != 0);
+    }
+
+    // Collects output meant for a terminal. The buffer is reused for every frame, and reserved
+    // with the given capacity when the first one begins, so one that's never used costs nothing.
+    class OutputBuffer
+    {
+    public:
+        explicit OutputBuffer(bool useSynchronizedOutput = true, size_t capacity = 0)
+            : useSynchronizedOutput(useSynchronizedOutput), capacity(capacity)
+        {
+        }
+
+        void BeginFrame()
+        {
+            if (buffer.capacity() < capacity)
+                buffer.reserve(capacity);
+
+            if (useSynchronizedOutput)
+                Append("\033[?2026h");
+        }
+
+        void EndFrame()
+        {
+            if (useSynchronizedOutput)
+                Append("\033[?2026l");
+        }
+
+        const string &GetData() const
+        {
+            return buffer;
+        }
+
+        void Clear()
+        {
+            buffer.clear();
+        }
+
+        void Append(char ch)
+        {
+            buffer += ch;
+        }
+
+        void Append(const char *text)
+        {
+            buffer += text;
+        }
+
+        void Append(const char *text, size_t length)
+        {
+            buffer.append(text, length);
+        }
+
+        void AppendNumber(int value)
+        {
+            char digits[12];
+            int length = 0;
+            do
+            {
+                digits[length++] = (char)('0' + value % 10);
+                value /= 10;
+            } while (value > 0);
+
+            while (length > 0)
+            {
+                buffer += digits[--length];
+            }
+        }
+
+        // The shortest SGR escape for the foreground color. rlutil numbers colors the way Windows
+        // does, with red and blue swapped compared to ANSI, and the bright ones get 90 to 97.
+        void AppendColor(uint8_t color)
+        {
+            Append("\033[");
+            if (color == DEFAULT_COLOR)
+            {
+                Append("39");
+            }
+            else
+            {
+                Append(color & 8 ? '9' : '3');
+                Append((char)('0' + (((color & 1) << 2) | (color & 2) | ((color & 4) >> 2))));
+            }
+            Append('m');
+        }
+
+        void AppendCursorMove(int row, int col)
+        {
+            Append("\033[");
+            AppendNumber(row + 1);
+            Append(';');
+            AppendNumber(col + 1);
+            Append('H');
+        }
+
+        // The same escapes rlutil's hidecursor() and showcursor() print through std::cout
+        void HideCursor()
+        {
+            Append("\033[?25l");
+        }
+
+        void ShowCursor()
+        {
+            Append("\033[?25h");
+        }
+
+    protected:
+        string buffer;
+        bool useSynchronizedOutput;
+        size_t capacity;
+    };
+
+    // Sends everything meant for the terminal with one write per frame, instead of going through
+    // iostreams
+    class ConsoleOutput : public OutputBuffer
+    {
+    public:
+        ConsoleOutput() : OutputBuffer(IsSynchronizedOutputSupported(), CONSOLE_OUTPUT_CAPACITY)
+        {
+            EnableAnsiEscapes();
+        }
+
+        // Sends the frame along with anything queued before it
+        void EndFrame()
+        {
+            OutputBuffer::EndFrame();
+            Flush();
+        }
+
+        void Flush()
+        {
+            WriteToConsole(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    };
+
+    // A fixed size grid of characters and their colors that makes up one screen of output. It is
+    // allocated once and then refilled in place every frame.
+    class Frame
+    {
+    public:
+        Frame(int rows, int cols)
+            : rows(rows), cols(cols), cells((size_t)rows * cols, ' '), colors((size_t)rows * cols, DEFAULT_COLOR)
+        {
+        }
+
+        int GetRows() const
+        {
+            return rows;
+        }
+
+        int GetCols() const
+        {
+            return cols;
+        }
+
+        char *Row(int row)
+        {
+            return &cells[(size_t)row * cols];
+        }
+
+        const char *Row(int row) const
+        {
+            return &cells[(size_t)row * cols];
+        }
+
+        uint8_t *Colors(int row)
+        {
+            return &colors[(size_t)row * cols];
+        }
+
+        const uint8_t *Colors(int row) const
+        {
+            return &colors[(size_t)row * cols];
+        }
+
+        void SetCell(int row, int col, char ch, uint8_t color)
+        {
+            Row(row)[col] = ch;
+            Colors(row)[col] = color;
+        }
+
+        void FillRow(int row, char ch, uint8_t color)
+        {
+            memset(Row(row), ch, cols);
+            memset(Colors(row), color, cols);
+        }
+
+        void Clear()
+        {
+            std::fill(cells.begin(), cells.end(), ' ');
+            std::fill(colors.begin(), colors.end(), DEFAULT_COLOR);
+        }
+
+        // Replaces a whole row with the text in the default color, padded with spaces and cut off
+        // at the frame width
+        void SetText(int row, const char *text, int length, int col = 0)
+        {
+            FillRow(row, ' ', DEFAULT_COLOR);
+            char *line = Row(row);
+
+            length = std::max(0, std::min(length, cols - col));
+            std::copy(text, text + length, line + col);
+        }
+
+        void SetCenteredText(int row, const char *text, int length)
+        {
+            SetText(row, text, length, std::max(0, (cols - length) / 2));
+        }
+
+    private:
+        int rows;
+        int cols;
+        vector<char> cells;
+        vector<uint8_t> colors;
+    };
+
+    // Keeps the last frame that was drawn and only sends the cells that changed since then. The
+    // color is only sent when it differs from the last one sent and spaces are drawn in whatever
+    // color is already set. Every run of changes starts with a cursor move, so they can be sent
+    // in any order, and ones that start in the same color are sent together.
+    //
+    // The output can be anything with OutputBuffer's methods. Finish() also needs it to have a
+    // Flush(), like ConsoleOutput does.
+    template <typename Output = ConsoleOutput>
+    class BasicDiffRenderer
+    {
+    public:
+        // Hides the cursor along with the first frame
+        void Start()
+        {
+            output.HideCursor();
+        }
+
+        void Draw(const Frame &frame)
+        {
+            output.BeginFrame();
+
+            if (!hasPreviousFrame || previous.GetRows() != frame.GetRows() || previous.GetCols() != frame.GetCols())
+            {
+                // Start from a blank screen, which is what a blank previous frame looks like
+                output.Append("\033[H\033[2J");
+                output.AppendColor(DEFAULT_COLOR);
+                currentColor = DEFAULT_COLOR;
+                if (previous.GetRows() != frame.GetRows() || previous.GetCols() != frame.GetCols())
+                {
+                    previous = Frame(frame.GetRows(), frame.GetCols());
+
+                    // Runs are at least MIN_SKIP_LENGTH cells apart, so this is as many as a
+                    // frame can have and they never need to grow mid game
+                    runs.reserve((size_t)frame.GetRows() * ((frame.GetCols() + MIN_SKIP_LENGTH) / (MIN_SKIP_LENGTH + 1)));
+                }
+                else
+                    previous.Clear();
+                hasPreviousFrame = true;
+            }
+
+            runs.clear();
+            for (int row = 0; row < frame.GetRows(); row++)
+            {
+                FindRowChanges(row, frame, previous);
+            }
+            AppendRuns(frame);
+
+            previous = frame;
+            output.EndFrame();
+        }
+
+        // Leaves the cursor, shown again, on the line below the last frame so later output
+        // doesn't overwrite it.
+        void Finish()
+        {
+            AppendFinish();
+            output.Flush();
+        }
+
+        // Queues what Finish() sends without flushing it, for outputs that aren't the console
+        void AppendFinish()
+        {
+            if (currentColor != DEFAULT_COLOR)
+            {
+                output.AppendColor(DEFAULT_COLOR);
+                currentColor = DEFAULT_COLOR;
+            }
+
+            output.AppendCursorMove(previous.GetRows(), 0);
+            output.ShowCursor();
+            hasPreviousFrame = false;
+        }
+
+        // Forgets what was drawn, so the next frame redraws the whole screen
+        void Reset()
+        {
+            hasPreviousFrame = false;
+        }
+
+        Output &GetOutput()
+        {
+            return output;
+        }
+
+        // The color the terminal is left drawing with after the last frame
+        uint8_t GetColor() const
+        {
+            return currentColor;
+        }
+
+    private:
+        // Unchanged gaps shorter than a cursor move are cheaper to resend than to skip over.
+        static const int MIN_SKIP_LENGTH = 8;
+
+        Frame previous{0, 0};
+        Output output;
+        bool hasPreviousFrame = false;
+
+        // Changed cells from start up to end, and the colors of the first and last ones that
+        // aren't spaces, or -1 if they're all spaces
+        struct CellRun
+        {
+            int row;
+            int start;
+            int end;
+            int firstColor;
+            int lastColor;
+        };
+
+        // Refilled every frame
+        vector<CellRun> runs;
+
+        // The color the terminal is drawing with, which carries over from one frame to the next
+        uint8_t currentColor = DEFAULT_COLOR;
+
+        static bool IsCellChanged(const char *line, const uint8_t *colors, const char *previousLine, const uint8_t *previousColors, int col)
+        {
+            return line[col] != previousLine[col] || (line[col] != ' ' && colors[col] != previousColors[col]);
+        }
+
+        void FindRowChanges(int row, const Frame &frame, const Frame &previous)
+        {
+            const char *line = frame.Row(row);
+            const uint8_t *colors = frame.Colors(row);
+            const char *previousLine = previous.Row(row);
+            const uint8_t *previousColors = previous.Colors(row);
+            int length = frame.GetCols();
+            int col = 0;
+
+            while (col < length)
+            {
+                if (!IsCellChanged(line, colors, previousLine, previousColors, col))
+                {
+                    col++;
+                    continue;
+                }
+
+                // Extend the run until we hit a long enough stretch of unchanged cells
+                int start = col;
+                int end = col + 1;
+                for (int next = end; next < length && next - end < MIN_SKIP_LENGTH; next++)
+                {
+                    if (IsCellChanged(line, colors, previousLine, previousColors, next))
+                        end = next + 1;
+                }
+
+                CellRun run = {row, start, end, -1, -1};
+                for (int i = start; i < end; i++)
+                {
+                    if (line[i] == ' ')
+                        continue;
+
+                    if (run.firstColor < 0)
+                        run.firstColor = colors[i];
+                    run.lastColor = colors[i];
+                }
+                runs.push_back(run);
+                col = end;
+            }
+        }
+
+        // Prefers runs all in the current color, then runs that at least start in it, so each
+        // color tends to be set once
+        static int GetRunPriority(const CellRun &run, int color)
+        {
+            bool isFirstMatching = run.firstColor < 0 || run.firstColor == color;
+            bool isLastMatching = run.lastColor < 0 || run.lastColor == color;
+            return isFirstMatching ? 1 + isLastMatching : 0;
+        }
+
+        void AppendRuns(const Frame &frame)
+        {
+            // Runs before `sent` have already been written out
+            for (size_t sent = 0; sent < runs.size(); sent++)
+            {
+                size_t next = sent;
+                int priority = GetRunPriority(runs[sent], currentColor);
+                for (size_t i = sent + 1; i < runs.size() && priority < 2; i++)
+                {
+                    int runPriority = GetRunPriority(runs[i], currentColor);
+                    if (runPriority > priority)
+                    {
+                        next = i;
+                        priority = runPriority;
+                    }
+                }
+                std::swap(runs[sent], runs[next]);
+
+                const CellRun &run = runs[sent];
+                output.AppendCursorMove(run.row, run.start);
+                AppendCells(frame.Row(run.row), frame.Colors(run.row), run.start, run.end);
+            }
+        }
+
+        // Sends the cells in as few pieces as the colors allow
+        void AppendCells(const char *line, const uint8_t *colors, int start, int end)
+        {
+            int spanStart = start;
+            for (int col = start; col < end; col++)
+            {
+                if (line[col] == ' ' || colors[col] == currentColor)
+                    continue;
+
+                output.Append(line + spanStart, col - spanStart);
+                output.AppendColor(colors[col]);
+                currentColor = colors[col];
+                spanStart = col;
+            }
+            output.Append(line + spanStart, end - spanStart);
+        }
+    };
+
+    typedef BasicDiffRenderer<> DiffRenderer;
+} // namespace RunButLikeActually
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <tagged_file.h>
+
+namespace RunButLikeActually
+{
+    const char REPLAY_MAGIC[4] = {'R', 'B', 'L', 'R'};
+    const uint8_t REPLAY_VERSION = 2;
+
+    // Replays from before the difficulty and level were kept, which can only have had neither
+    const uint8_t REPLAY_OLDEST_VERSION = 1;
+
+    // Everything needed to play a game again exactly: the seed it was started with, what its
+    // obstacles were made with, the ticks jumps were pressed on and the tick it ended on. On disk
+    // that's a small header, the seed, difficulty and level hash as varints and then one varint
+    // per event, holding the ticks since the previous event shifted left by one with the low bit
+    // set for the end of the game.
+    class Replay
+    {
+    public:
+        uint64_t seed = 0;
+
+        // The game's DifficultyCurve::pointsPerStep
+        int pointsPerStep = 0;
+
+        // Level::GetHash() of the level it was played on, or 0 if there wasn't one. The level is
+        // too big to keep, so it has to be given again to play the replay.
+        uint64_t levelHash = 0;
+
+        std::vector<long long> jumpTicks;
+
+        // -1 until the game it's recording ends
+        long long endTick = -1;
+
+        void RecordJump(long long tick)
+        {
+            jumpTicks.push_back(tick);
+        }
+
+        bool Save(const std::string &path) const
+        {
+            std::vector<uint8_t> data = StartTaggedFile(REPLAY_MAGIC, REPLAY_VERSION);
+            AppendVarint(data, seed);
+            AppendVarint(data, (uint64_t)std::max(0, pointsPerStep));
+            AppendVarint(data, levelHash);
+
+            long long previousTick = 0;
+            for (long long tick : jumpTicks)
+            {
+                AppendVarint(data, (uint64_t)(tick - previousTick) << 1);
+                previousTick = tick;
+            }
+            AppendVarint(data, ((uint64_t)(std::max(endTick, previousTick) - previousTick) << 1) | 1);
+            return SaveTaggedFile(path, data);
+        }
+
+        // Returns false if the file can't be read or isn't a complete replay
+        bool Load(const std::string &path)
+        {
+            std::vector<uint8_t> data;
+            if (!LoadTaggedFile(path, REPLAY_MAGIC, REPLAY_VERSION, data, REPLAY_OLDEST_VERSION))
+                return false;
+
+            size_t offset = TAGGED_FILE_HEADER_SIZE;
+            jumpTicks.clear();
+            pointsPerStep = 0;
+            levelHash = 0;
+            if (!ReadVarint(data, offset, seed))
+                return false;
+
+            uint64_t value;
+            if (GetTaggedFileVersion(data) >= 2)
+            {
+                if (!ReadVarint(data, offset, value) || value > INT32_MAX || !ReadVarint(data, offset, levelHash))
+                    return false;
+                pointsPerStep = (int)value;
+            }
+
+            long long tick = 0;
+            while (ReadVarint(data, offset, value))
+            {
+                tick += (long long)(value >> 1);
+                if (value & 1)
+                {
+                    endTick = tick;
+                    return true;
+                }
+                jumpTicks.push_back(tick);
+            }
+
+            return false;
+        }
+
+    private:
+        static void AppendVarint(std::vector<uint8_t> &data, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                data.push_back((uint8_t)(value | 0x80));
+                value >>= 7;
+            }
+            data.push_back((uint8_t)value);
+        }
+
+        static bool ReadVarint(const std::vector<uint8_t> &data, size_t &offset, uint64_t &value)
+        {
+            value = 0;
+            for (int shift = 0; shift < 64 && offset < data.size(); shift += 7)
+            {
+                uint8_t byte = data[offset++];
+                value |= (uint64_t)(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    return true;
+            }
+            return false;
+        }
+    };
+} // namespace RunButLikeActually
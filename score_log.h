@@ -0,0 +1,426 @@
+#pragma once
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include <profiler.h>
+#include <spsc_queue.h>
+
+namespace RunButLikeActually
+{
+    const char SCORE_LOG_MAGIC[4] = {'R', 'B', 'L', 'S'};
+    const uint32_t SCORE_LOG_VERSION = 1;
+    const char SCORE_LOG_DEFAULT_PATH[] = "scores.rbls";
+
+    // Best runs the log's header keeps track of
+    const uint32_t SCORE_LOG_TOP_COUNT = 16;
+
+    // Records the file grows by whenever it fills up
+    const uint64_t SCORE_LOG_GROWTH = 256;
+
+    // Runs that can be waiting to be written before any more are dropped
+    const size_t SCORE_LOG_QUEUE_SIZE = 64;
+
+    // One run, exactly as it's stored in the log
+    struct ScoreRecord
+    {
+        // Seconds since the Unix epoch when the run ended
+        int64_t endTime = 0;
+        uint64_t seed = 0;
+        int64_t ticks = 0;
+        int64_t frames = 0;
+        int64_t droppedTicks = 0;
+        int64_t droppedFrames = 0;
+        int64_t droppedInputEvents = 0;
+        int32_t score = 0;
+
+        // Set if the stage timings were recorded, otherwise they're all 0
+        int32_t isProfiled = 0;
+
+        // Microseconds at the 50th and 99th percentiles of each ProfileStage, over its last
+        // PROFILER_WINDOW samples
+        float stageP50[(size_t)ProfileStage::Count] = {};
+        float stageP99[(size_t)ProfileStage::Count] = {};
+    };
+
+    static_assert(sizeof(ScoreRecord) == 64 + 8 * (size_t)ProfileStage::Count, "Score records are written as they are, so they can't have any padding");
+
+    // The start of the log, followed by recordCount records. The file can have room for more.
+    struct ScoreLogHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t recordSize;
+        uint32_t topCount;
+        uint64_t recordCount;
+
+        // Indices of the best records, best first. Equal scores stay in the order they were set.
+        uint64_t top[SCORE_LOG_TOP_COUNT];
+    };
+
+    // Keeps a ScoreRecord of every run in an append only, memory mapped file. The header keeps
+    // the count and an index of the best runs up to date, so opening the log and listing the
+    // high scores only touches the header and those runs however long the history gets.
+    //
+    // Append() only queues the record. A writer thread copies it into the mapping and updates
+    // the header, so whoever records a run never waits on the disk. Records only count once
+    // they're completely written, so a crash part way through loses that run and nothing else.
+    class ScoreLog
+    {
+    public:
+        ScoreLog() = default;
+
+        ~ScoreLog()
+        {
+            Close();
+        }
+
+        ScoreLog(const ScoreLog &) = delete;
+        ScoreLog &operator=(const ScoreLog &) = delete;
+
+        // Opens the log, creating it if it doesn't exist. Returns false if it can't be, if
+        // something else has it open or if it isn't a log this version can read.
+        bool Open(const std::string &path)
+        {
+            Close();
+            if (!OpenFile(path))
+            {
+                Close();
+                return false;
+            }
+
+            isRunning = true;
+            writer = std::thread([this]() { RunWriter(); });
+            return true;
+        }
+
+        // Opens an existing log just to read it, which works while something else is writing to
+        // it. It reads the log as it was when it was opened, and can't be appended to.
+        bool OpenForReading(const std::string &path)
+        {
+            Close();
+            isReadOnly = true;
+            if (!OpenFile(path))
+            {
+                Close();
+                return false;
+            }
+            return true;
+        }
+
+        // Writes everything that's been queued and closes the file
+        void Close()
+        {
+            if (writer.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(wakeMutex);
+                    isRunning = false;
+                }
+                wake.notify_one();
+                writer.join();
+            }
+
+            UnmapFile();
+#ifdef _WIN32
+            if (file != INVALID_HANDLE_VALUE)
+                CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (fd >= 0)
+                close(fd);
+            fd = -1;
+#endif
+            isReadOnly = false;
+        }
+
+        bool IsOpen() const
+        {
+            return data != nullptr;
+        }
+
+        // Queues the record to be written. Returns false, dropping it, if the log isn't open
+        // or is too far behind. Runs that ended before their first tick aren't kept, so they
+        // can't crowd the top scores. Only meant to be called from one thread.
+        bool Append(const ScoreRecord &record)
+        {
+            if (record.ticks <= 0)
+                return true;
+
+            if (!writer.joinable() || !queue.TryPush(record))
+                return false;
+
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                appendedCount++;
+            }
+            wake.notify_one();
+            return true;
+        }
+
+        // Waits until everything appended so far has been written
+        void Flush()
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            written.wait(lock, [this]() { return writtenCount >= appendedCount || !writer.joinable(); });
+        }
+
+        uint64_t GetRecordCount()
+        {
+            std::lock_guard<std::mutex> lock(mapMutex);
+            return data ? GetHeader().recordCount : 0;
+        }
+
+        // Up to count of the best runs, best first
+        std::vector<ScoreRecord> GetTopScores(size_t count)
+        {
+            std::lock_guard<std::mutex> lock(mapMutex);
+            std::vector<ScoreRecord> scores;
+            if (!data)
+                return scores;
+
+            const ScoreLogHeader &header = GetHeader();
+            for (size_t i = 0; i < std::min<size_t>(count, header.topCount); i++)
+            {
+                scores.push_back(GetRecords()[header.top[i]]);
+            }
+            return scores;
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = NULL;
+#else
+        int fd = -1;
+#endif
+        uint8_t *data = nullptr;
+        uint64_t mappedSize = 0;
+
+        // Read only logs use a copy of the header taken when they were opened, since the writer
+        // can be changing the one in the file at any time. Records before its count never change.
+        bool isReadOnly = false;
+        ScoreLogHeader headerCopy = {};
+
+        // Held by the writer while it changes the mapping, and by anyone reading it
+        std::mutex mapMutex;
+
+        SpscQueue<ScoreRecord, SCORE_LOG_QUEUE_SIZE> queue;
+        std::thread writer;
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        std::condition_variable written;
+        bool isRunning = false;
+        size_t appendedCount = 0;
+        size_t writtenCount = 0;
+
+        static uint64_t GetFileSize(uint64_t recordCount)
+        {
+            return sizeof(ScoreLogHeader) + recordCount * sizeof(ScoreRecord);
+        }
+
+        ScoreLogHeader &GetHeader()
+        {
+            return isReadOnly ? headerCopy : *(ScoreLogHeader *)data;
+        }
+
+        ScoreRecord *GetRecords()
+        {
+            return (ScoreRecord *)(data + sizeof(ScoreLogHeader));
+        }
+
+        bool OpenFile(const std::string &path)
+        {
+            uint64_t fileSize;
+#ifdef _WIN32
+            // Not sharing write access keeps anyone else from writing to it at the same time.
+            // Readers have to share it with whoever's writing.
+            if (isReadOnly)
+                file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+            else
+                file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+            LARGE_INTEGER size;
+            if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size))
+                return false;
+            fileSize = (uint64_t)size.QuadPart;
+#else
+            // Only writers take the lock, so readers never have to wait for a game to finish
+            fd = isReadOnly ? open(path.c_str(), O_RDONLY) : open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            struct stat status;
+            if (fd < 0 || (!isReadOnly && flock(fd, LOCK_EX | LOCK_NB) != 0) || fstat(fd, &status) != 0)
+                return false;
+            fileSize = (uint64_t)status.st_size;
+#endif
+
+            bool isNew = fileSize == 0 && !isReadOnly;
+            if ((!isNew && fileSize < sizeof(ScoreLogHeader)) || !MapFile(isNew ? GetFileSize(SCORE_LOG_GROWTH) : fileSize))
+                return false;
+
+            if (isReadOnly)
+                headerCopy = *(const ScoreLogHeader *)data;
+
+            ScoreLogHeader &header = GetHeader();
+            if (isNew)
+            {
+                memcpy(header.magic, SCORE_LOG_MAGIC, sizeof(SCORE_LOG_MAGIC));
+                header.version = SCORE_LOG_VERSION;
+                header.recordSize = sizeof(ScoreRecord);
+                header.topCount = 0;
+                header.recordCount = 0;
+                return true;
+            }
+
+            if (memcmp(header.magic, SCORE_LOG_MAGIC, sizeof(SCORE_LOG_MAGIC)) != 0 || header.version != SCORE_LOG_VERSION ||
+                header.recordSize != sizeof(ScoreRecord) || header.topCount > SCORE_LOG_TOP_COUNT ||
+                GetFileSize(header.recordCount) > fileSize)
+                return false;
+
+            // The index is read straight into the records, so a damaged one would read past them
+            for (uint32_t i = 0; i < header.topCount; i++)
+            {
+                if (header.top[i] >= header.recordCount)
+                    return false;
+            }
+            return true;
+        }
+
+        // Maps the first size bytes of the file, growing it to fit. The old mapping is only
+        // replaced if the new one works.
+        bool MapFile(uint64_t size)
+        {
+#ifdef _WIN32
+            HANDLE newMapping = CreateFileMappingA(file, NULL, isReadOnly ? PAGE_READONLY : PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+            void *view = newMapping ? MapViewOfFile(newMapping, isReadOnly ? FILE_MAP_READ : FILE_MAP_WRITE, 0, 0, (SIZE_T)size) : NULL;
+            if (!view)
+            {
+                if (newMapping)
+                    CloseHandle(newMapping);
+                return false;
+            }
+
+            UnmapFile();
+            mapping = newMapping;
+#else
+            struct stat status;
+            if (fstat(fd, &status) != 0 || ((uint64_t)status.st_size < size && (isReadOnly || ftruncate(fd, (off_t)size) != 0)))
+                return false;
+
+            void *view = mmap(NULL, (size_t)size, isReadOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (view == MAP_FAILED)
+                return false;
+
+            UnmapFile();
+#endif
+            data = (uint8_t *)view;
+            mappedSize = size;
+            return true;
+        }
+
+        void UnmapFile()
+        {
+            if (!data)
+                return;
+
+#ifdef _WIN32
+            if (!isReadOnly)
+                FlushViewOfFile(data, 0);
+            UnmapViewOfFile(data);
+            CloseHandle(mapping);
+            mapping = NULL;
+#else
+            munmap(data, (size_t)mappedSize);
+#endif
+            data = nullptr;
+            mappedSize = 0;
+        }
+
+        void RunWriter()
+        {
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(wakeMutex);
+                    wake.wait(lock, [this]() { return writtenCount < appendedCount || !isRunning; });
+                    if (writtenCount >= appendedCount)
+                        return;
+                }
+
+                ScoreRecord record;
+                size_t count = 0;
+                while (queue.TryPop(record))
+                {
+                    WriteRecord(record);
+                    count++;
+                }
+
+                // Starts the pages on their way to the disk without waiting for them
+#ifndef _WIN32
+                {
+                    std::lock_guard<std::mutex> lock(mapMutex);
+                    msync(data, (size_t)mappedSize, MS_ASYNC);
+                }
+#endif
+
+                {
+                    std::lock_guard<std::mutex> lock(wakeMutex);
+                    writtenCount += count;
+                }
+                written.notify_all();
+            }
+        }
+
+        // Records that don't fit because the disk is full are lost
+        void WriteRecord(const ScoreRecord &record)
+        {
+            std::lock_guard<std::mutex> lock(mapMutex);
+            uint64_t index = GetHeader().recordCount;
+            if (GetFileSize(index + 1) > mappedSize && !MapFile(GetFileSize(index + SCORE_LOG_GROWTH)))
+                return;
+
+            GetRecords()[index] = record;
+            GetHeader().recordCount = index + 1;
+            AddToTop(index);
+        }
+
+        void AddToTop(uint64_t index)
+        {
+            ScoreLogHeader &header = GetHeader();
+            int32_t score = GetRecords()[index].score;
+
+            uint32_t position = header.topCount;
+            while (position > 0 && GetRecords()[header.top[position - 1]].score < score)
+            {
+                position--;
+            }
+
+            if (position == SCORE_LOG_TOP_COUNT)
+                return;
+
+            uint32_t count = std::min(header.topCount + 1, SCORE_LOG_TOP_COUNT);
+            for (uint32_t i = count - 1; i > position; i--)
+            {
+                header.top[i] = header.top[i - 1];
+            }
+            header.top[position] = index;
+            header.topCount = count;
+        }
+    };
+} // namespace RunButLikeActually
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <socket.h>
+#include <game.h>
+#include <thread_pool.h>
+
+namespace RunButLikeActually
+{
+    // Sessions a pool thread takes at a time
+    const size_t GAME_SERVER_CHUNK_SIZE = 16;
+
+    // Output queued for a player past which frames are skipped until they catch up
+    const size_t GAME_SERVER_MAX_PENDING = 1 << 16;
+
+    const int GAME_SERVER_STATS_INTERVAL_MS = 5000;
+
+    // Asks telnet clients to send keys as they're pressed instead of a line at a time, and to
+    // leave echoing them to us. Anything else just gets these bytes before the first frame,
+    // which clears the screen.
+    const char TELNET_CHARACTER_MODE[] = {'\xff', '\xfb', '\x01', '\xff', '\xfb', '\x03'};
+
+    const uint8_t TELNET_IAC = 255;
+    const uint8_t TELNET_WILL = 251;
+    const uint8_t TELNET_SB = 250;
+    const uint8_t TELNET_SE = 240;
+
+    struct GameServerOptions
+    {
+        int port = 0;
+
+        // Threads the sessions are ticked on, 0 uses one per core
+        int threads = 0;
+
+        // Each session gets its own seed worked out from this and the order it connected in
+        uint64_t seed = RandomSeed();
+
+        // Anyone connecting after this many sessions are running is turned away
+        size_t maxSessions = 10000;
+
+        // Also gets every finished game. Has to outlive the server.
+        ScoreLog *scores = nullptr;
+    };
+
+    // Covers the time since the last stats were reported
+    struct GameServerStats
+    {
+        size_t sessions = 0;
+        long long tickBatches = 0;
+        long long droppedTicks = 0;
+
+        // Time taken to tick and draw every session, per batch of ticks
+        double meanUpdateMs = 0;
+        double maxUpdateMs = 0;
+    };
+
+    // Hosts a game for everyone who connects over TCP, all on one scheduler thread plus a
+    // WorkStealingPool instead of the two threads each Game::Run() needs. The scheduler waits on
+    // every socket at once with SocketPoller until the next tick is due, passing on any keys that
+    // came in, and then has the pool tick every session and send it the cells that changed.
+    //
+    // Players connect with telnet, or with `stty raw -echo; nc host port`, and need a terminal
+    // big enough for the board. SPACE jumps and ESC leaves.
+    template <typename Config = GameConfig>
+    class BasicGameServer
+    {
+    public:
+        typedef BasicGame<Config> GameType;
+
+        explicit BasicGameServer(GameServerOptions options) : options(options), pool(options.threads)
+        {
+        }
+
+        ~BasicGameServer()
+        {
+            for (std::unique_ptr<Session> &session : sessions)
+            {
+                CloseSocket(session->stream.GetSocket());
+            }
+
+            if (listener != INVALID_SOCKET_HANDLE)
+                CloseSocket(listener);
+
+            if (isStarted)
+                StopSockets();
+        }
+
+        BasicGameServer(const BasicGameServer &) = delete;
+        BasicGameServer &operator=(const BasicGameServer &) = delete;
+
+        // Returns false if the port can't be listened on
+        bool Start()
+        {
+            if (!StartSockets())
+                return false;
+            isStarted = true;
+
+            listener = ListenOnPort(options.port);
+            return listener != INVALID_SOCKET_HANDLE && poller.Add(listener, nullptr);
+        }
+
+        int GetThreadCount() const
+        {
+            return pool.GetThreadCount();
+        }
+
+        // Hosts sessions until Stop() is called, calling onStats with GameServerStats every
+        // GAME_SERVER_STATS_INTERVAL_MS
+        template <typename OnStats>
+        void Run(const OnStats &onStats)
+        {
+            FixedTimestep timestep(std::chrono::milliseconds(GAME_SPEED), GAME_MAX_CATCH_UP_TICKS);
+            timestep.Start();
+
+            GameServerStats stats;
+            double totalUpdateMs = 0;
+            FixedTimestep::Clock::time_point nextStatsTime = FixedTimestep::Clock::now() + std::chrono::milliseconds(GAME_SERVER_STATS_INTERVAL_MS);
+
+            isRunning = true;
+            while (isRunning)
+            {
+                FixedTimestep::Clock::duration untilTick = timestep.NextTickTime() - FixedTimestep::Clock::now();
+                long long waitUs = std::chrono::duration_cast<std::chrono::microseconds>(untilTick).count();
+                PollSockets((int)std::max(0LL, (waitUs + 999) / 1000));
+
+                int dueTicks = timestep.Advance();
+                if (dueTicks == 0)
+                    continue;
+
+                FixedTimestep::Clock::time_point start = FixedTimestep::Clock::now();
+                pool.ParallelFor(sessions.size(), GAME_SERVER_CHUNK_SIZE, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++)
+                    {
+                        sessions[i]->Update(dueTicks, start);
+                    }
+                });
+                FixedTimestep::Clock::time_point end = FixedTimestep::Clock::now();
+                RemoveFinishedSessions();
+
+                double updateMs = std::chrono::duration<double, std::milli>(end - start).count();
+                totalUpdateMs += updateMs;
+                stats.maxUpdateMs = std::max(stats.maxUpdateMs, updateMs);
+                stats.tickBatches++;
+
+                if (end >= nextStatsTime)
+                {
+                    stats.sessions = sessions.size();
+                    stats.droppedTicks = timestep.GetDroppedTicks() - droppedTicks;
+                    stats.meanUpdateMs = totalUpdateMs / stats.tickBatches;
+                    onStats(stats);
+
+                    droppedTicks = timestep.GetDroppedTicks();
+                    stats = GameServerStats();
+                    totalUpdateMs = 0;
+                    nextStatsTime = end + std::chrono::milliseconds(GAME_SERVER_STATS_INTERVAL_MS);
+                }
+            }
+        }
+
+        // Safe to call from any thread
+        void Stop()
+        {
+            isRunning = false;
+        }
+
+    private:
+        class Session : public GameType
+        {
+        public:
+            SocketStream stream;
+
+            // Set by the scheduler when the player leaves
+            bool isQuitting = false;
+
+            // Set once the session can be closed
+            bool isFinished = false;
+
+            Session(GameOptions gameOptions, SocketHandle socket) : GameType(gameOptions), stream(socket)
+            {
+                stream.Queue(TELNET_CHARACTER_MODE, sizeof(TELNET_CHARACTER_MODE));
+                encoder.Start();
+            }
+
+            // Called by the scheduler with whatever the player sent
+            void HandleInput(const char *data, size_t length)
+            {
+                for (size_t i = 0; i < length; i++)
+                {
+                    uint8_t byte = (uint8_t)data[i];
+
+                    // Telnet negotiation is skipped over, whatever it says
+                    switch (telnetState)
+                    {
+                    case TelnetState::Command:
+                        telnetState = byte == TELNET_SB ? TelnetState::Subnegotiation : byte >= TELNET_WILL ? TelnetState::Option : TelnetState::None;
+                        continue;
+                    case TelnetState::Option:
+                        telnetState = TelnetState::None;
+                        continue;
+                    case TelnetState::Subnegotiation:
+                        telnetState = byte == TELNET_IAC ? TelnetState::SubnegotiationCommand : TelnetState::Subnegotiation;
+                        continue;
+                    case TelnetState::SubnegotiationCommand:
+                        telnetState = byte == TELNET_SE ? TelnetState::None : TelnetState::Subnegotiation;
+                        continue;
+                    case TelnetState::None:
+                        break;
+                    }
+
+                    if (byte == TELNET_IAC)
+                        telnetState = TelnetState::Command;
+                    else if (byte == ' ')
+                        this->QueueKey(rlutil::KEY_SPACE);
+                    else if (byte == 27 || byte == 3)
+                        isQuitting = true;
+                }
+            }
+
+            // Called on a pool thread
+            void Update(int ticks, SocketStream::Clock::time_point now)
+            {
+                if (isQuitting)
+                {
+                    isFinished = true;
+                    return;
+                }
+
+                for (int i = 0; i < ticks && !this->isPlayerColliding; i++)
+                {
+                    this->Step();
+                }
+
+                if (!isGameOverQueued)
+                    DrawFrame();
+
+                // Once the last frame has gone out there's nothing left to do
+                if (!stream.Send(now) || (isGameOverQueued && stream.GetQueuedSize() == 0))
+                    isFinished = true;
+            }
+
+        private:
+            enum class TelnetState : uint8_t
+            {
+                None,
+                Command,
+                Option,
+                Subnegotiation,
+                SubnegotiationCommand
+            };
+
+            BasicDiffRenderer<OutputBuffer> encoder;
+
+            // Set while frames are being skipped. The encoder has been reset, so the next frame
+            // after they catch up is a whole one.
+            bool isBehind = false;
+
+            TelnetState telnetState = TelnetState::None;
+            bool isGameOverQueued = false;
+
+            // The last frame, with the score below it, is always queued
+            void DrawFrame()
+            {
+                if (isBehind && stream.GetQueuedSize() > 0 && !this->isPlayerColliding)
+                    return;
+                isBehind = false;
+
+                this->BuildFrame();
+                encoder.Draw(this->frame);
+
+                if (this->isPlayerColliding)
+                {
+                    encoder.AppendFinish();
+
+                    char text[64];
+                    int length = snprintf(text, sizeof(text), "GAME OVER. SCORE: %d\r\n", this->GetScore());
+                    encoder.GetOutput().Append(text, (size_t)std::max(0, length));
+                    isGameOverQueued = true;
+                }
+
+                OutputBuffer &output = encoder.GetOutput();
+                if (stream.GetQueuedSize() + output.GetData().size() > GAME_SERVER_MAX_PENDING && !this->isPlayerColliding)
+                {
+                    isBehind = true;
+                    encoder.Reset();
+                }
+                else
+                {
+                    stream.Queue(output.GetData());
+                }
+                output.Clear();
+            }
+        };
+
+        GameServerOptions options;
+        WorkStealingPool pool;
+        SocketPoller poller;
+        SocketHandle listener = INVALID_SOCKET_HANDLE;
+        bool isStarted = false;
+        std::atomic<bool> isRunning{false};
+
+        std::vector<std::unique_ptr<Session>> sessions;
+        std::vector<Session *> closedSessions;
+        uint64_t sessionCount = 0;
+        long long droppedTicks = 0;
+
+        // Handles new connections and input until the timeout, or until something arrives
+        void PollSockets(int timeoutMs)
+        {
+            char input[256];
+            closedSessions.clear();
+            poller.Wait(timeoutMs, [&](void *data) {
+                if (!data)
+                {
+                    AcceptSessions();
+                    return;
+                }
+
+                Session &session = *(Session *)data;
+                size_t length;
+                do
+                {
+                    if (!session.stream.Receive(input, sizeof(input), length))
+                    {
+                        session.isQuitting = true;
+                        closedSessions.push_back(&session);
+                        return;
+                    }
+                    session.HandleInput(input, length);
+                } while (length > 0);
+            });
+
+            // Otherwise they'd keep being reported until they're removed on the next tick
+            for (Session *session : closedSessions)
+            {
+                poller.Remove(session->stream.GetSocket());
+            }
+        }
+
+        void AcceptSessions()
+        {
+            SocketHandle socket;
+            while ((socket = AcceptSocket(listener)) != INVALID_SOCKET_HANDLE)
+            {
+                if (sessions.size() >= options.maxSessions)
+                {
+                    const char full[] = "The server is full.\r\n";
+                    send(socket, full, sizeof(full) - 1, SOCKET_SEND_FLAGS);
+                    CloseSocket(socket);
+                    continue;
+                }
+
+                GameOptions gameOptions;
+                gameOptions.seed = options.seed + sessionCount++ * 0x9e3779b97f4a7c15ull;
+
+                // Sessions are only added to the poller once they're in the list, so input
+                // always has somewhere to go
+                sessions.emplace_back(new Session(gameOptions, socket));
+                if (!poller.Add(socket, sessions.back().get()))
+                    sessions.back()->isQuitting = true;
+            }
+        }
+
+        void RemoveFinishedSessions()
+        {
+            for (size_t i = 0; i < sessions.size();)
+            {
+                if (!sessions[i]->isFinished)
+                {
+                    i++;
+                    continue;
+                }
+
+                if (options.scores)
+                    options.scores->Append(sessions[i]->GetScoreRecord());
+
+                poller.Remove(sessions[i]->stream.GetSocket());
+                CloseSocket(sessions[i]->stream.GetSocket());
+                sessions[i] = std::move(sessions.back());
+                sessions.pop_back();
+            }
+        }
+    };
+
+    typedef BasicGameServer<> GameServer;
+} // namespace RunButLikeActually
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace RunButLikeActually
+{
+    // The handful of 32 bit integer vector operations the multi game kernels need, using the
+    // widest instruction set the compiler targets. Comparisons return all ones in lanes where
+    // they hold and zero elsewhere, so their results double as masks.
+    struct SimdLanes
+    {
+#if defined(__AVX2__)
+        typedef __m256i Vector;
+        static const int WIDTH = 8;
+        static constexpr const char *NAME = "AVX2";
+
+        static Vector Load(const int32_t *data) { return _mm256_loadu_si256((const __m256i *)data); }
+        static void Store(int32_t *data, Vector v) { _mm256_storeu_si256((__m256i *)data, v); }
+        static Vector Set(int32_t value) { return _mm256_set1_epi32(value); }
+        static Vector Add(Vector a, Vector b) { return _mm256_add_epi32(a, b); }
+        static Vector Sub(Vector a, Vector b) { return _mm256_sub_epi32(a, b); }
+        static Vector And(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+        static Vector Or(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+        static Vector AndNot(Vector a, Vector b) { return _mm256_andnot_si256(b, a); }
+        static Vector Greater(Vector a, Vector b) { return _mm256_cmpgt_epi32(a, b); }
+        static Vector Equal(Vector a, Vector b) { return _mm256_cmpeq_epi32(a, b); }
+#elif defined(__SSE2__) || defined(_M_X64)
+        typedef __m128i Vector;
+        static const int WIDTH = 4;
+        static constexpr const char *NAME = "SSE2";
+
+        static Vector Load(const int32_t *data) { return _mm_loadu_si128((const __m128i *)data); }
+        static void Store(int32_t *data, Vector v) { _mm_storeu_si128((__m128i *)data, v); }
+        static Vector Set(int32_t value) { return _mm_set1_epi32(value); }
+        static Vector Add(Vector a, Vector b) { return _mm_add_epi32(a, b); }
+        static Vector Sub(Vector a, Vector b) { return _mm_sub_epi32(a, b); }
+        static Vector And(Vector a, Vector b) { return _mm_and_si128(a, b); }
+        static Vector Or(Vector a, Vector b) { return _mm_or_si128(a, b); }
+        static Vector AndNot(Vector a, Vector b) { return _mm_andnot_si128(b, a); }
+        static Vector Greater(Vector a, Vector b) { return _mm_cmpgt_epi32(a, b); }
+        static Vector Equal(Vector a, Vector b) { return _mm_cmpeq_epi32(a, b); }
+#elif defined(__ARM_NEON)
+        typedef int32x4_t Vector;
+        static const int WIDTH = 4;
+        static constexpr const char *NAME = "NEON";
+
+        static Vector Load(const int32_t *data) { return vld1q_s32(data); }
+        static void Store(int32_t *data, Vector v) { vst1q_s32(data, v); }
+        static Vector Set(int32_t value) { return vdupq_n_s32(value); }
+        static Vector Add(Vector a, Vector b) { return vaddq_s32(a, b); }
+        static Vector Sub(Vector a, Vector b) { return vsubq_s32(a, b); }
+        static Vector And(Vector a, Vector b) { return vandq_s32(a, b); }
+        static Vector Or(Vector a, Vector b) { return vorrq_s32(a, b); }
+        static Vector AndNot(Vector a, Vector b) { return vbicq_s32(a, b); }
+        static Vector Greater(Vector a, Vector b) { return vreinterpretq_s32_u32(vcgtq_s32(a, b)); }
+        static Vector Equal(Vector a, Vector b) { return vreinterpretq_s32_u32(vceqq_s32(a, b)); }
+#else
+        typedef int32_t Vector;
+        static const int WIDTH = 1;
+        static constexpr const char *NAME = "scalar";
+
+        static Vector Load(const int32_t *data) { return *data; }
+        static void Store(int32_t *data, Vector v) { *data = v; }
+        static Vector Set(int32_t value) { return value; }
+        static Vector Add(Vector a, Vector b) { return a + b; }
+        static Vector Sub(Vector a, Vector b) { return a - b; }
+        static Vector And(Vector a, Vector b) { return a & b; }
+        static Vector Or(Vector a, Vector b) { return a | b; }
+        static Vector AndNot(Vector a, Vector b) { return a & ~b; }
+        static Vector Greater(Vector a, Vector b) { return -(int32_t)(a > b); }
+        static Vector Equal(Vector a, Vector b) { return -(int32_t)(a == b); }
+#endif
+    };
+} // namespace RunButLikeActually
@@ -0,0 +1,325 @@
+#pragma once
+
+// Winsock has to be included before anything else includes windows.h
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+#endif
+
+#include <array>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace RunButLikeActually
+{
+    // Connections that don't take any of their queued output for this long are given up on
+    const int SOCKET_SEND_TIMEOUT_MS = 10000;
+
+    // Most sockets SocketPoller reports on from one wait
+    const int SOCKET_POLLER_BATCH = 256;
+
+#ifdef _WIN32
+    typedef SOCKET SocketHandle;
+    const SocketHandle INVALID_SOCKET_HANDLE = INVALID_SOCKET;
+#else
+    typedef int SocketHandle;
+    const SocketHandle INVALID_SOCKET_HANDLE = -1;
+#endif
+
+#ifdef MSG_NOSIGNAL
+    const int SOCKET_SEND_FLAGS = MSG_NOSIGNAL;
+#else
+    const int SOCKET_SEND_FLAGS = 0;
+#endif
+
+    // Winsock needs starting before any sockets are made, and stopping as many times after
+    inline bool StartSockets()
+    {
+#ifdef _WIN32
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+        return true;
+#endif
+    }
+
+    inline void StopSockets()
+    {
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+
+    inline void CloseSocket(SocketHandle socket)
+    {
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        close(socket);
+#endif
+    }
+
+    // Sets up a socket so it never blocks, doesn't raise SIGPIPE and sends small writes straight away
+    inline bool PrepareSocket(SocketHandle socket)
+    {
+        int isEnabled = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char *)&isEnabled, sizeof(isEnabled));
+#ifdef SO_NOSIGPIPE
+        setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &isEnabled, sizeof(isEnabled));
+#endif
+
+#ifdef _WIN32
+        u_long isNonBlocking = 1;
+        return ioctlsocket(socket, FIONBIO, &isNonBlocking) == 0;
+#else
+        int flags = fcntl(socket, F_GETFL, 0);
+        return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+    }
+
+    // Whether the last socket call failed only because it would have had to wait
+    inline bool IsSocketWouldBlock()
+    {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+    }
+
+    // A non-blocking socket accepting TCP connections on the port on every interface, or
+    // INVALID_SOCKET_HANDLE if that can't be done
+    inline SocketHandle ListenOnPort(int port)
+    {
+        SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listener == INVALID_SOCKET_HANDLE)
+            return INVALID_SOCKET_HANDLE;
+
+#ifndef _WIN32
+        int isEnabled = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &isEnabled, sizeof(isEnabled));
+#endif
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons((uint16_t)port);
+
+        if (bind(listener, (const sockaddr *)&address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0 || !PrepareSocket(listener))
+        {
+            CloseSocket(listener);
+            return INVALID_SOCKET_HANDLE;
+        }
+        return listener;
+    }
+
+    // The next connection waiting on a listener, set up with PrepareSocket(), or
+    // INVALID_SOCKET_HANDLE once there are none
+    inline SocketHandle AcceptSocket(SocketHandle listener)
+    {
+        while (true)
+        {
+            SocketHandle socket = accept(listener, NULL, NULL);
+            if (socket == INVALID_SOCKET_HANDLE || PrepareSocket(socket))
+                return socket;
+            CloseSocket(socket);
+        }
+    }
+
+    // Output queued for one connection, handed to the socket as fast as it takes it without
+    // ever waiting. Closing the socket is left to whoever owns the stream.
+    class SocketStream
+    {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        explicit SocketStream(SocketHandle socket) : socket(socket), lastProgress(Clock::now())
+        {
+        }
+
+        SocketHandle GetSocket() const
+        {
+            return socket;
+        }
+
+        size_t GetQueuedSize() const
+        {
+            return pending.size() - sent;
+        }
+
+        void Queue(const std::string &data)
+        {
+            pending += data;
+        }
+
+        void Queue(const char *data, size_t length)
+        {
+            pending.append(data, length);
+        }
+
+        // Returns false once the connection should be closed, because it failed or hasn't
+        // taken anything for SOCKET_SEND_TIMEOUT_MS
+        bool Send(Clock::time_point now)
+        {
+            while (sent < pending.size())
+            {
+                int length = (int)send(socket, pending.data() + sent, (int)(pending.size() - sent), SOCKET_SEND_FLAGS);
+                if (length < 0)
+                {
+                    if (!IsSocketWouldBlock())
+                        return false;
+                    break;
+                }
+
+                sent += (size_t)length;
+                lastProgress = now;
+            }
+
+            if (sent == pending.size())
+            {
+                pending.clear();
+                sent = 0;
+                lastProgress = now;
+                return true;
+            }
+
+            return now - lastProgress < std::chrono::milliseconds(SOCKET_SEND_TIMEOUT_MS);
+        }
+
+        // Reads whatever has arrived without waiting for more. Returns false once the other end
+        // has closed the connection or it failed.
+        bool Receive(char *data, size_t capacity, size_t &length)
+        {
+            length = 0;
+            int received = (int)recv(socket, data, (int)capacity, 0);
+            if (received > 0)
+                length = (size_t)received;
+            return received > 0 || (received < 0 && IsSocketWouldBlock());
+        }
+
+    private:
+        SocketHandle socket;
+
+        // Output from sent onwards hasn't been taken by the socket yet
+        std::string pending;
+        size_t sent = 0;
+
+        Clock::time_point lastProgress;
+    };
+
+    // Waits for any of a set of sockets to have something to read, using epoll on Linux and
+    // poll() elsewhere. Each socket is registered with a pointer that's handed back when it's ready.
+    class SocketPoller
+    {
+    public:
+        SocketPoller()
+        {
+#ifdef __linux__
+            epollFd = epoll_create1(0);
+#endif
+        }
+
+        ~SocketPoller()
+        {
+#ifdef __linux__
+            if (epollFd >= 0)
+                close(epollFd);
+#endif
+        }
+
+        SocketPoller(const SocketPoller &) = delete;
+        SocketPoller &operator=(const SocketPoller &) = delete;
+
+        bool Add(SocketHandle socket, void *data)
+        {
+#ifdef __linux__
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.ptr = data;
+            return epoll_ctl(epollFd, EPOLL_CTL_ADD, socket, &event) == 0;
+#else
+            pollfd entry = {};
+            entry.fd = socket;
+            entry.events = POLLIN;
+            sockets.push_back(entry);
+            socketData.push_back(data);
+            return true;
+#endif
+        }
+
+        void Remove(SocketHandle socket)
+        {
+#ifdef __linux__
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, socket, NULL);
+#else
+            for (size_t i = 0; i < sockets.size(); i++)
+            {
+                if (sockets[i].fd != socket)
+                    continue;
+
+                sockets[i] = sockets.back();
+                sockets.pop_back();
+                socketData[i] = socketData.back();
+                socketData.pop_back();
+                return;
+            }
+#endif
+        }
+
+        // Waits up to timeoutMs for sockets that can be read from, or have closed, and calls
+        // onReady with the pointer each was added with. Sockets can't be added or removed from
+        // inside onReady.
+        template <typename OnReady>
+        void Wait(int timeoutMs, const OnReady &onReady)
+        {
+#ifdef __linux__
+            int count = epoll_wait(epollFd, events.data(), SOCKET_POLLER_BATCH, timeoutMs);
+            for (int i = 0; i < count; i++)
+            {
+                onReady(events[i].data.ptr);
+            }
+#else
+#ifdef _WIN32
+            int count = sockets.empty() ? 0 : WSAPoll(sockets.data(), (ULONG)sockets.size(), timeoutMs);
+            if (sockets.empty())
+                Sleep(timeoutMs);
+#else
+            int count = poll(sockets.data(), (nfds_t)sockets.size(), timeoutMs);
+#endif
+            for (size_t i = 0; i < sockets.size() && count > 0; i++)
+            {
+                if (sockets[i].revents == 0)
+                    continue;
+
+                count--;
+                onReady(socketData[i]);
+            }
+#endif
+        }
+
+    private:
+#ifdef __linux__
+        int epollFd = -1;
+        std::array<epoll_event, SOCKET_POLLER_BATCH> events;
+#else
+        std::vector<pollfd> sockets;
+        std::vector<void *> socketData;
+#endif
+    };
+} // namespace RunButLikeActually
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <socket.h>
+#include <renderer.h>
+#include <triple_buffer.h>
+
+namespace RunButLikeActually
+{
+    // Output queued for a spectator past which they're skipped until they catch up
+    const size_t SPECTATOR_MAX_PENDING = 1 << 16;
+
+    // How often sockets are looked at while no frames are coming in
+    const int SPECTATOR_POLL_MS = 10;
+
+    // Streams frames to anyone who connects over TCP, as the same escapes DiffRenderer sends to
+    // the console, so something like `nc host port` in a big enough terminal is all it takes to
+    // watch. Spectators get a whole frame when they join and then only the cells that change.
+    //
+    // Everything past handing over frames happens on one I/O thread with non-blocking sockets.
+    // A spectator who falls behind is skipped until what's queued for them has gone out and then
+    // gets a whole frame again, so they jump ahead instead of holding anyone else up.
+    class SpectatorServer
+    {
+    public:
+        SpectatorServer() = default;
+
+        ~SpectatorServer()
+        {
+            Stop();
+        }
+
+        SpectatorServer(const SpectatorServer &) = delete;
+        SpectatorServer &operator=(const SpectatorServer &) = delete;
+
+        // Listens on the port on every interface. Returns false if it can't.
+        bool Start(int port)
+        {
+            if (!StartSockets())
+                return false;
+            isStarted = true;
+
+            listener = ListenOnPort(port);
+            if (listener == INVALID_SOCKET_HANDLE)
+                return false;
+
+            frames.reset(new TripleBuffer<Frame>(Frame(0, 0)));
+            isRunning = true;
+            ioThread = std::thread([this]() { RunIoThread(); });
+            return true;
+        }
+
+        void Stop()
+        {
+            if (ioThread.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(wakeMutex);
+                    isRunning = false;
+                }
+                wake.notify_one();
+                ioThread.join();
+            }
+
+            for (Spectator &spectator : spectators)
+            {
+                CloseSocket(spectator.stream.GetSocket());
+            }
+            spectators.clear();
+            spectatorCount = 0;
+
+            if (listener != INVALID_SOCKET_HANDLE)
+            {
+                CloseSocket(listener);
+                listener = INVALID_SOCKET_HANDLE;
+            }
+
+            if (isStarted)
+                StopSockets();
+            isStarted = false;
+        }
+
+        // Hands a copy of the frame to the I/O thread, replacing any it hasn't sent yet. Only
+        // meant to be called from one thread.
+        void Publish(const Frame &frame)
+        {
+            if (!frames)
+                return;
+
+            frames->GetWriteBuffer() = frame;
+            frames->Publish();
+
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+            }
+            wake.notify_one();
+        }
+
+        size_t GetSpectatorCount() const
+        {
+            return spectatorCount;
+        }
+
+    private:
+        struct Spectator
+        {
+            SocketStream stream;
+
+            // Set for newcomers and anyone who fell behind, until they're sent a whole frame
+            bool needsKeyframe = true;
+        };
+
+        SocketHandle listener = INVALID_SOCKET_HANDLE;
+        bool isStarted = false;
+
+        std::unique_ptr<TripleBuffer<Frame>> frames;
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        std::atomic<bool> isRunning{false};
+        std::thread ioThread;
+        std::atomic<size_t> spectatorCount{0};
+
+        // Only touched by the I/O thread while it runs
+        std::vector<Spectator> spectators;
+        BasicDiffRenderer<OutputBuffer> deltas;
+        BasicDiffRenderer<OutputBuffer> keyframes;
+        bool hasFrame = false;
+        bool isKeyframeCurrent = false;
+
+        void RunIoThread()
+        {
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(wakeMutex);
+                    wake.wait_for(lock, std::chrono::milliseconds(SPECTATOR_POLL_MS), [this]() { return frames->HasUpdate() || !isRunning; });
+                }
+
+                if (!isRunning)
+                    break;
+
+                SocketHandle socket;
+                while ((socket = AcceptSocket(listener)) != INVALID_SOCKET_HANDLE)
+                {
+                    spectators.push_back({SocketStream(socket)});
+                    spectatorCount = spectators.size();
+                }
+
+                if (frames->Update())
+                    BroadcastFrame(frames->GetReadBuffer());
+                SendPending();
+            }
+        }
+
+        void BroadcastFrame(const Frame &frame)
+        {
+            OutputBuffer &output = deltas.GetOutput();
+            output.Clear();
+            deltas.Draw(frame);
+            hasFrame = true;
+            isKeyframeCurrent = false;
+
+            const std::string &delta = output.GetData();
+            for (Spectator &spectator : spectators)
+            {
+                if (spectator.needsKeyframe)
+                    continue;
+
+                if (spectator.stream.GetQueuedSize() + delta.size() > SPECTATOR_MAX_PENDING)
+                    spectator.needsKeyframe = true;
+                else
+                    spectator.stream.Queue(delta);
+            }
+        }
+
+        // The whole of the last frame, leaving the spectator's terminal in the same state as
+        // everyone else's so the next delta applies to it
+        const std::string &GetKeyframe()
+        {
+            OutputBuffer &output = keyframes.GetOutput();
+            if (!isKeyframeCurrent)
+            {
+                output.Clear();
+                keyframes.Reset();
+                keyframes.Start();
+                keyframes.Draw(frames->GetReadBuffer());
+                if (keyframes.GetColor() != deltas.GetColor())
+                    output.AppendColor(deltas.GetColor());
+                isKeyframeCurrent = true;
+            }
+            return output.GetData();
+        }
+
+        void SendPending()
+        {
+            SocketStream::Clock::time_point now = SocketStream::Clock::now();
+
+            for (size_t i = 0; i < spectators.size();)
+            {
+                if (SendPending(spectators[i], now))
+                {
+                    i++;
+                    continue;
+                }
+
+                CloseSocket(spectators[i].stream.GetSocket());
+                spectators[i] = std::move(spectators.back());
+                spectators.pop_back();
+                spectatorCount = spectators.size();
+            }
+        }
+
+        // Returns false once the spectator should be disconnected
+        bool SendPending(Spectator &spectator, SocketStream::Clock::time_point now)
+        {
+            // Anything spectators type is ignored, but reading it is how we find out they've left
+            char input[256];
+            size_t length;
+            if (!spectator.stream.Receive(input, sizeof(input), length))
+                return false;
+
+            // Whole frames are only ever sent between the others, never part way through one
+            if (spectator.needsKeyframe && spectator.stream.GetQueuedSize() == 0 && hasFrame)
+            {
+                spectator.stream.Queue(GetKeyframe());
+                spectator.needsKeyframe = false;
+            }
+
+            return spectator.stream.Send(now);
+        }
+    };
+} // namespace RunButLikeActually
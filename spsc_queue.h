@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <stddef.h>
+
+namespace RunButLikeActually
+{
+    // Bounded lock free queue for exactly one producer thread and one consumer thread.
+    template <typename T, size_t Capacity>
+    class SpscQueue
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+
+    public:
+        // Producer only. Returns false if the queue is full.
+        bool TryPush(const T &item)
+        {
+            size_t tail = this->tail.load(std::memory_order_relaxed);
+            if (tail - cachedHead == Capacity)
+            {
+                cachedHead = head.load(std::memory_order_acquire);
+                if (tail - cachedHead == Capacity)
+                    return false;
+            }
+
+            items[tail & (Capacity - 1)] = item;
+            this->tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer only. Returns false if the queue is empty.
+        bool TryPop(T &item)
+        {
+            size_t head = this->head.load(std::memory_order_relaxed);
+            if (head == cachedTail)
+            {
+                cachedTail = tail.load(std::memory_order_acquire);
+                if (head == cachedTail)
+                    return false;
+            }
+
+            item = items[head & (Capacity - 1)];
+            this->head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        // The two ends live on separate cache lines so the threads don't fight over them.
+        // Each side also keeps a stale copy of the other's index and only reloads it when
+        // the queue looks full or empty.
+        alignas(64) std::atomic<size_t> head{0};
+        size_t cachedTail = 0;
+
+        alignas(64) std::atomic<size_t> tail{0};
+        size_t cachedHead = 0;
+
+        alignas(64) std::array<T, Capacity> items = {};
+    };
+} // namespace RunButLikeActually
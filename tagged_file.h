@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace RunButLikeActually
+{
+    // Every file we save starts with four bytes of magic and a version byte
+    const size_t TAGGED_FILE_HEADER_SIZE = 5;
+
+    // The header of a file, for the rest of it to be appended to
+    inline std::vector<uint8_t> StartTaggedFile(const char (&magic)[4], uint8_t version)
+    {
+        std::vector<uint8_t> data(magic, magic + sizeof(magic));
+        data.push_back(version);
+        return data;
+    }
+
+    inline uint8_t GetTaggedFileVersion(const std::vector<uint8_t> &data)
+    {
+        return data[TAGGED_FILE_HEADER_SIZE - 1];
+    }
+
+    inline bool SaveTaggedFile(const std::string &path, const std::vector<uint8_t> &data)
+    {
+        FILE *file = fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+
+        bool isWritten = fwrite(data.data(), 1, data.size(), file) == data.size();
+        return fclose(file) == 0 && isWritten;
+    }
+
+    // Reads the whole file, header and all, so what follows starts at TAGGED_FILE_HEADER_SIZE.
+    // Returns false if it can't be read or doesn't start with the given magic and a version from
+    // oldestVersion to version.
+    inline bool LoadTaggedFile(const std::string &path, const char (&magic)[4], uint8_t version, std::vector<uint8_t> &data, uint8_t oldestVersion = 0)
+    {
+        FILE *file = fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+
+        data.clear();
+        uint8_t chunk[4096];
+        size_t length;
+        while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        {
+            data.insert(data.end(), chunk, chunk + length);
+        }
+        fclose(file);
+
+        if (oldestVersion == 0)
+            oldestVersion = version;
+
+        return data.size() >= TAGGED_FILE_HEADER_SIZE && memcmp(data.data(), magic, sizeof(magic)) == 0 &&
+               GetTaggedFileVersion(data) >= oldestVersion && GetTaggedFileVersion(data) <= version;
+    }
+} // namespace RunButLikeActually
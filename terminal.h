@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+namespace RunButLikeActually
+{
+    struct TerminalSize
+    {
+        int rows;
+        int cols;
+    };
+
+    // Looks up the size of the terminal stdout is attached to. Returns false if it isn't one.
+    inline bool GetTerminalSize(TerminalSize &size)
+    {
+#ifdef _WIN32
+        CONSOLE_SCREEN_BUFFER_INFO info;
+        if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &info))
+            return false;
+
+        size.rows = info.srWindow.Bottom - info.srWindow.Top + 1;
+        size.cols = info.srWindow.Right - info.srWindow.Left + 1;
+#else
+        struct winsize window;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &window) != 0)
+            return false;
+
+        size.rows = window.ws_row;
+        size.cols = window.ws_col;
+#endif
+        return size.rows > 0 && size.cols > 0;
+    }
+
+    // Keeps track of whether the terminal could have changed size, so it only has to be asked
+    // for its size after that happens. On POSIX this listens for SIGWINCH for as long as it
+    // lives. Windows reports resizes as console input, so ConsoleInput passes them on instead.
+    class TerminalResizeWatcher
+    {
+    public:
+        TerminalResizeWatcher()
+        {
+            // Whatever size the terminal is now hasn't been looked at yet
+            Flag() = true;
+
+#ifndef _WIN32
+            struct sigaction action = {};
+            action.sa_handler = [](int) { NotifyResized(); };
+            action.sa_flags = SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            hasSavedAction = sigaction(SIGWINCH, &action, &savedAction) == 0;
+#endif
+        }
+
+        ~TerminalResizeWatcher()
+        {
+#ifndef _WIN32
+            if (hasSavedAction)
+                sigaction(SIGWINCH, &savedAction, NULL);
+#endif
+        }
+
+        TerminalResizeWatcher(const TerminalResizeWatcher &) = delete;
+        TerminalResizeWatcher &operator=(const TerminalResizeWatcher &) = delete;
+
+        // Returns true once for every batch of resizes since the last call
+        bool HasResized()
+        {
+            return Flag().exchange(false);
+        }
+
+        // Safe to call from a signal handler or any thread
+        static void NotifyResized()
+        {
+            Flag() = true;
+        }
+
+    private:
+#ifndef _WIN32
+        struct sigaction savedAction;
+        bool hasSavedAction = false;
+#endif
+
+        static std::atomic<bool> &Flag()
+        {
+            static std::atomic<bool> flag{true};
+            return flag;
+        }
+    };
+} // namespace RunButLikeActually
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RunButLikeActually
+{
+    // A fixed set of threads that share out parallel loops. The chunks of a loop are dealt out
+    // to every thread's own queue up front, and a thread that runs out steals from the front of
+    // the others' queues, so uneven chunks still finish at about the same time. The thread
+    // calling ParallelFor() works through the loop too.
+    class WorkStealingPool
+    {
+    public:
+        // 0 uses one thread per core
+        explicit WorkStealingPool(int threadCount)
+        {
+            if (threadCount <= 0)
+                threadCount = (int)std::max(1u, std::thread::hardware_concurrency());
+
+            for (int i = 0; i < threadCount; i++)
+            {
+                queues.emplace_back(new WorkQueue());
+            }
+
+            for (int i = 1; i < threadCount; i++)
+            {
+                workers.emplace_back([this, i]() { RunWorker(i); });
+            }
+        }
+
+        ~WorkStealingPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(loopMutex);
+                isStopping = true;
+            }
+            loopStarted.notify_all();
+
+            for (std::thread &worker : workers)
+            {
+                worker.join();
+            }
+        }
+
+        WorkStealingPool(const WorkStealingPool &) = delete;
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        int GetThreadCount() const
+        {
+            return (int)queues.size();
+        }
+
+        // Calls body(begin, end) for ranges of up to chunkSize indices that together cover 0 to
+        // count, and returns once they've all run. Only one loop runs at a time.
+        template <typename Body>
+        void ParallelFor(size_t count, size_t chunkSize, const Body &body)
+        {
+            if (count == 0)
+                return;
+
+            chunkSize = std::max<size_t>(chunkSize, 1);
+            size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+            {
+                std::lock_guard<std::mutex> lock(loopMutex);
+                loopBody = &body;
+                loopInvoke = [](const void *body, size_t begin, size_t end) { (*(const Body *)body)(begin, end); };
+                remainingChunks = chunkCount;
+
+                // Neighbouring chunks go to the same thread, which keeps them on one core unless
+                // they get stolen
+                for (size_t i = 0; i < queues.size(); i++)
+                {
+                    WorkQueue &queue = *queues[i];
+                    std::lock_guard<std::mutex> queueLock(queue.mutex);
+                    queue.ranges.clear();
+                    queue.head = 0;
+
+                    size_t firstChunk = chunkCount * i / queues.size();
+                    size_t lastChunk = chunkCount * (i + 1) / queues.size();
+                    for (size_t chunk = firstChunk; chunk < lastChunk; chunk++)
+                    {
+                        queue.ranges.push_back({chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize)});
+                    }
+                }
+                loopNumber++;
+            }
+            loopStarted.notify_all();
+
+            RunChunks(0);
+
+            std::unique_lock<std::mutex> lock(loopMutex);
+            loopFinished.wait(lock, [this]() { return remainingChunks == 0; });
+        }
+
+    private:
+        struct Range
+        {
+            size_t begin;
+            size_t end;
+        };
+
+        // The owner takes ranges from the back and thieves from the front
+        struct alignas(64) WorkQueue
+        {
+            std::mutex mutex;
+            std::vector<Range> ranges;
+            size_t head = 0;
+        };
+
+        std::vector<std::unique_ptr<WorkQueue>> queues;
+        std::vector<std::thread> workers;
+
+        std::mutex loopMutex;
+        std::condition_variable loopStarted;
+        std::condition_variable loopFinished;
+        long long loopNumber = 0;
+        bool isStopping = false;
+
+        // Set before a loop's ranges are queued, so anyone who takes one of them sees its body
+        const void *loopBody = nullptr;
+        void (*loopInvoke)(const void *, size_t, size_t) = nullptr;
+        std::atomic<size_t> remainingChunks{0};
+
+        void RunWorker(int index)
+        {
+            long long seenLoop = 0;
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(loopMutex);
+                    loopStarted.wait(lock, [&]() { return loopNumber != seenLoop || isStopping; });
+                    if (isStopping)
+                        return;
+                    seenLoop = loopNumber;
+                }
+
+                RunChunks(index);
+            }
+        }
+
+        bool TryPop(WorkQueue &queue, Range &range)
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.head == queue.ranges.size())
+                return false;
+
+            range = queue.ranges.back();
+            queue.ranges.pop_back();
+            return true;
+        }
+
+        bool TrySteal(WorkQueue &queue, Range &range)
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.head == queue.ranges.size())
+                return false;
+
+            range = queue.ranges[queue.head++];
+            return true;
+        }
+
+        bool TryTake(int index, Range &range)
+        {
+            if (TryPop(*queues[index], range))
+                return true;
+
+            for (size_t i = 1; i < queues.size(); i++)
+            {
+                if (TrySteal(*queues[(index + i) % queues.size()], range))
+                    return true;
+            }
+            return false;
+        }
+
+        void RunChunks(int index)
+        {
+            Range range;
+            while (TryTake(index, range))
+            {
+                loopInvoke(loopBody, range.begin, range.end);
+
+                if (--remainingChunks == 0)
+                {
+                    // Taking the lock means the caller is either waiting or hasn't checked yet
+                    {
+                        std::lock_guard<std::mutex> lock(loopMutex);
+                    }
+                    loopFinished.notify_all();
+                }
+            }
+        }
+    };
+} // namespace RunButLikeActually
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+
+namespace RunButLikeActually
+{
+    // Hands out simulation ticks at a fixed rate based on how much real time has passed, so the
+    // game runs at the same speed however long each frame takes to draw.
+    class FixedTimestep
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // Ticks are at least one clock period long, however short a tick is asked for
+        FixedTimestep(Clock::duration tickLength, int maxCatchUpTicks)
+            : tickLength(std::max(tickLength, Clock::duration(1))), maxCatchUpTicks(maxCatchUpTicks)
+        {
+        }
+
+        void Start()
+        {
+            previousTime = Clock::now();
+            accumulator = Clock::duration::zero();
+            droppedTicks = 0;
+        }
+
+        // Returns the number of ticks that are due. After a long stall at most maxCatchUpTicks
+        // are returned and the rest are dropped, otherwise the game would fast forward.
+        int Advance()
+        {
+            Clock::time_point now = Clock::now();
+            accumulator += now - previousTime;
+            previousTime = now;
+
+            // Worked out by division, so a stall is as cheap as a tick however short ticks are
+            long long dueTicks = accumulator / tickLength;
+            int ticks = (int)std::min<long long>(dueTicks, maxCatchUpTicks);
+            droppedTicks += dueTicks - ticks;
+            accumulator %= tickLength;
+            return ticks;
+        }
+
+        Clock::time_point NextTickTime() const
+        {
+            return previousTime + (tickLength - accumulator);
+        }
+
+        long long GetDroppedTicks() const
+        {
+            return droppedTicks;
+        }
+
+    private:
+        Clock::duration tickLength;
+        int maxCatchUpTicks;
+
+        Clock::time_point previousTime;
+        Clock::duration accumulator = Clock::duration::zero();
+        long long droppedTicks = 0;
+    };
+} // namespace RunButLikeActually
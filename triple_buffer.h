@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+namespace RunButLikeActually
+{
+    // Hands the latest value from one producer thread to one consumer thread without locking.
+    // The producer fills its own buffer and publishes it by swapping it with the middle one, and
+    // the consumer swaps the middle one for its own when there's something new. Values the
+    // consumer never got to are overwritten, so it always sees the newest one.
+    template <typename T>
+    class TripleBuffer
+    {
+    public:
+        explicit TripleBuffer(const T &initial) : buffers{initial, initial, initial}
+        {
+        }
+
+        // Producer only. The buffer to fill in before calling Publish().
+        T &GetWriteBuffer()
+        {
+            return buffers[writeIndex];
+        }
+
+        // Producer only. Returns false if this replaced a value the consumer never read.
+        bool Publish()
+        {
+            uint8_t previous = middle.exchange(writeIndex | FRESH_BIT, std::memory_order_acq_rel);
+            writeIndex = previous & INDEX_MASK;
+            return !(previous & FRESH_BIT);
+        }
+
+        bool HasUpdate() const
+        {
+            return (middle.load(std::memory_order_acquire) & FRESH_BIT) != 0;
+        }
+
+        // Consumer only. Moves on to the newest published value, if there is one since the last
+        // call. Returns false if there wasn't.
+        bool Update()
+        {
+            if (!HasUpdate())
+                return false;
+
+            uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+            readIndex = previous & INDEX_MASK;
+            return true;
+        }
+
+        // Consumer only
+        const T &GetReadBuffer() const
+        {
+            return buffers[readIndex];
+        }
+
+    private:
+        // The middle index is tagged with whether it has been published since the consumer
+        // last took it
+        static const uint8_t INDEX_MASK = 3;
+        static const uint8_t FRESH_BIT = 4;
+
+        T buffers[3];
+
+        alignas(64) uint8_t writeIndex = 0;
+        alignas(64) std::atomic<uint8_t> middle{1};
+        alignas(64) uint8_t readIndex = 2;
+    };
+} // namespace RunButLikeActually